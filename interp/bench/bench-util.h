@@ -0,0 +1,237 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_BENCH_UTIL_H_
+#define WABT_BENCH_UTIL_H_
+
+// Shared by the programs in bench/: a writer for generating their input
+// modules, and timing. Run them with "make RELEASE=1 bench".
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "src/binary.h"
+#include "src/common.h"
+#include "src/leb128.h"
+#include "src/opcode.h"
+#include "src/stream.h"
+
+namespace wabt {
+namespace bench {
+
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  double Seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Appends binary-format values to a buffer. Sized() and Section() prefix a
+// nested writer's bytes with their length.
+class WasmWriter {
+ public:
+  const std::vector<uint8_t>& data() { return stream_.output_buffer().data; }
+  size_t size() { return data().size(); }
+
+  void Header() {
+    stream_.WriteU32(WABT_BINARY_MAGIC, "magic");
+    stream_.WriteU32(WABT_BINARY_VERSION, "version");
+  }
+  void U8(uint8_t value) { stream_.WriteU8(value, "u8"); }
+  void U32(uint32_t value) { WriteU32Leb128(&stream_, value, "u32"); }
+  void I32(int32_t value) { WriteS32Leb128(&stream_, value, "i32"); }
+  void I64(int64_t value) { WriteS64Leb128(&stream_, value, "i64"); }
+  void ValueType(Type type) { I32(static_cast<int32_t>(type)); }
+  void Name(string_view name) {
+    U32(name.size());
+    stream_.WriteData(name.data(), name.size(), "name");
+  }
+  void Op(Opcode opcode) {
+    if (opcode.HasPrefix()) {
+      U8(opcode.GetPrefix());
+      U32(opcode.GetCode());
+    } else {
+      U8(opcode.GetCode());
+    }
+  }
+  void Sized(WasmWriter& writer) {
+    U32(writer.size());
+    stream_.WriteData(writer.data().data(), writer.size(), "bytes");
+  }
+  void Section(BinarySection section, WasmWriter& writer) {
+    U8(static_cast<uint8_t>(section));
+    Sized(writer);
+  }
+
+ private:
+  MemoryStream stream_;
+};
+
+// Returns a module with |num_funcs| functions of type (i32, i32) -> i32 and
+// a memory, the first function exported as "f". Each body has
+// |statements_per_func| random statements mixing locals, constants of
+// every LEB128 length, blocks, loops, ifs, calls and loads, to resemble
+// compiled code. The functions aren't meant to be run; loops may not end.
+inline std::vector<uint8_t> MakeCodeModule(Index num_funcs,
+                                           Index statements_per_func) {
+  std::mt19937 random(1);
+  WasmWriter module;
+  module.Header();
+
+  WasmWriter types;
+  types.U32(1);
+  types.ValueType(Type::Func);
+  types.U32(2);
+  types.ValueType(Type::I32);
+  types.ValueType(Type::I32);
+  types.U32(1);
+  types.ValueType(Type::I32);
+  module.Section(BinarySection::Type, types);
+
+  WasmWriter funcs;
+  funcs.U32(num_funcs);
+  for (Index i = 0; i < num_funcs; ++i)
+    funcs.U32(0);
+  module.Section(BinarySection::Function, funcs);
+
+  WasmWriter memory;
+  memory.U32(1);
+  memory.U8(0);
+  memory.U32(1);
+  module.Section(BinarySection::Memory, memory);
+
+  WasmWriter exports;
+  exports.U32(1);
+  exports.Name("f");
+  exports.U8(static_cast<uint8_t>(ExternalKind::Func));
+  exports.U32(0);
+  module.Section(BinarySection::Export, exports);
+
+  WasmWriter code;
+  code.U32(num_funcs);
+  for (Index i = 0; i < num_funcs; ++i) {
+    // Locals 2 and 3 are i32s, 4 is an i64.
+    WasmWriter body;
+    body.U32(2);
+    body.U32(2);
+    body.ValueType(Type::I32);
+    body.U32(1);
+    body.ValueType(Type::I64);
+    for (Index j = 0; j < statements_per_func; ++j) {
+      // Skew the constants towards small values, as compilers do.
+      uint32_t bits = 1 + random() % 32;
+      int32_t constant = static_cast<int32_t>(random() >> (32 - bits));
+      switch (random() % 6) {
+        case 0:
+          body.Op(Opcode::GetLocal);
+          body.U32(0);
+          body.Op(Opcode::I32Const);
+          body.I32(constant);
+          body.Op(Opcode::I32Add);
+          body.Op(Opcode::SetLocal);
+          body.U32(2);
+          break;
+        case 1:
+          body.Op(Opcode::Block);
+          body.ValueType(Type::Void);
+          body.Op(Opcode::GetLocal);
+          body.U32(1);
+          body.Op(Opcode::BrIf);
+          body.U32(0);
+          body.Op(Opcode::GetLocal);
+          body.U32(2);
+          body.Op(Opcode::I32Const);
+          body.I32(constant);
+          body.Op(Opcode::I32Mul);
+          body.Op(Opcode::SetLocal);
+          body.U32(3);
+          body.Op(Opcode::End);
+          break;
+        case 2:
+          body.Op(Opcode::Loop);
+          body.ValueType(Type::Void);
+          body.Op(Opcode::GetLocal);
+          body.U32(3);
+          body.Op(Opcode::I32Const);
+          body.I32(1);
+          body.Op(Opcode::I32Sub);
+          body.Op(Opcode::TeeLocal);
+          body.U32(3);
+          body.Op(Opcode::BrIf);
+          body.U32(0);
+          body.Op(Opcode::End);
+          break;
+        case 3:
+          body.Op(Opcode::I64Const);
+          body.I64(static_cast<int64_t>(constant) * random());
+          body.Op(Opcode::GetLocal);
+          body.U32(4);
+          body.Op(Opcode::I64Mul);
+          body.Op(Opcode::SetLocal);
+          body.U32(4);
+          break;
+        case 4:
+          body.Op(Opcode::GetLocal);
+          body.U32(0);
+          body.Op(Opcode::GetLocal);
+          body.U32(1);
+          body.Op(Opcode::Call);
+          body.U32(random() % num_funcs);
+          body.Op(Opcode::SetLocal);
+          body.U32(2);
+          break;
+        case 5:
+          body.Op(Opcode::GetLocal);
+          body.U32(1);
+          body.Op(Opcode::If);
+          body.ValueType(Type::Void);
+          body.Op(Opcode::GetLocal);
+          body.U32(0);
+          body.Op(Opcode::I32Load);
+          body.U32(2);
+          body.U32(random() % 1024);
+          body.Op(Opcode::SetLocal);
+          body.U32(2);
+          body.Op(Opcode::Else);
+          body.Op(Opcode::GetLocal);
+          body.U32(3);
+          body.Op(Opcode::SetLocal);
+          body.U32(2);
+          body.Op(Opcode::End);
+          break;
+      }
+    }
+    body.Op(Opcode::GetLocal);
+    body.U32(2);
+    body.Op(Opcode::End);
+    code.Sized(body);
+  }
+  module.Section(BinarySection::Code, code);
+  return module.data();
+}
+
+}  // namespace bench
+}  // namespace wabt
+
+#endif  // WABT_BENCH_UTIL_H_
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// memory.copy and memory.fill against the guest loops they replace.
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "bench/bench-util.h"
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+
+using namespace wabt;
+using namespace wabt::bench;
+using namespace wabt::interp;
+
+namespace {
+
+const int kRuns = 5;
+// The bytes each measurement copies or fills, over as many calls as needed.
+const uint32_t kBytesPerRun = 1 << 20;
+const uint32_t kSrc = 0;
+const uint32_t kDst = 2 * WABT_PAGE_SIZE;
+
+// The loop a compiler emits for memcpy (|copy|) or memset without bulk
+// memory, moving a word at a time; |n| must be a multiple of 4:
+//   (func (param $dst i32) (param $src_or_value i32) (param $n i32)
+//     (local $i i32)
+//     (block (loop
+//       (br_if 1 (i32.ge_u (get_local $i) (get_local $n)))
+//       (i32.store (i32.add (get_local $dst) (get_local $i))
+//         copy: (i32.load (i32.add (get_local $src) (get_local $i)))
+//         fill: (get_local $value))
+//       (set_local $i (i32.add (get_local $i) (i32.const 4)))
+//       (br 0))))
+void WriteLoopBody(WasmWriter* code, bool copy) {
+  WasmWriter body;
+  body.U32(1);
+  body.U32(1);
+  body.ValueType(Type::I32);
+  body.Op(Opcode::Block);
+  body.ValueType(Type::Void);
+  body.Op(Opcode::Loop);
+  body.ValueType(Type::Void);
+  body.Op(Opcode::GetLocal);
+  body.U32(3);
+  body.Op(Opcode::GetLocal);
+  body.U32(2);
+  body.Op(Opcode::I32GeU);
+  body.Op(Opcode::BrIf);
+  body.U32(1);
+  body.Op(Opcode::GetLocal);
+  body.U32(0);
+  body.Op(Opcode::GetLocal);
+  body.U32(3);
+  body.Op(Opcode::I32Add);
+  body.Op(Opcode::GetLocal);
+  body.U32(1);
+  if (copy) {
+    body.Op(Opcode::GetLocal);
+    body.U32(3);
+    body.Op(Opcode::I32Add);
+    body.Op(Opcode::I32Load);
+    body.U32(2);
+    body.U32(0);
+  }
+  body.Op(Opcode::I32Store);
+  body.U32(2);
+  body.U32(0);
+  body.Op(Opcode::GetLocal);
+  body.U32(3);
+  body.Op(Opcode::I32Const);
+  body.I32(4);
+  body.Op(Opcode::I32Add);
+  body.Op(Opcode::SetLocal);
+  body.U32(3);
+  body.Op(Opcode::Br);
+  body.U32(0);
+  body.Op(Opcode::End);
+  body.Op(Opcode::End);
+  body.Op(Opcode::End);
+  code->Sized(body);
+}
+
+//   (func (param i32 i32 i32)
+//     (memory.copy|memory.fill (get_local 0) (get_local 1) (get_local 2)))
+void WriteBulkBody(WasmWriter* code, Opcode opcode) {
+  WasmWriter body;
+  body.U32(0);
+  for (uint32_t i = 0; i < 3; ++i) {
+    body.Op(Opcode::GetLocal);
+    body.U32(i);
+  }
+  body.Op(opcode);
+  body.U8(0);
+  if (opcode == Opcode::MemoryCopy)
+    body.U8(0);
+  body.Op(Opcode::End);
+  code->Sized(body);
+}
+
+const char* const kExportNames[] = {"copy_loop", "memory.copy", "fill_loop",
+                                    "memory.fill"};
+
+// A module with 4 pages of memory, exporting the functions named in
+// kExportNames, all of type (i32, i32, i32) -> ().
+std::vector<uint8_t> MakeBulkModule() {
+  WasmWriter module;
+  module.Header();
+
+  WasmWriter types;
+  types.U32(1);
+  types.ValueType(Type::Func);
+  types.U32(3);
+  for (int i = 0; i < 3; ++i)
+    types.ValueType(Type::I32);
+  types.U32(0);
+  module.Section(BinarySection::Type, types);
+
+  WasmWriter funcs;
+  funcs.U32(4);
+  for (int i = 0; i < 4; ++i)
+    funcs.U32(0);
+  module.Section(BinarySection::Function, funcs);
+
+  WasmWriter memory;
+  memory.U32(1);
+  memory.U8(0);
+  memory.U32(4);
+  module.Section(BinarySection::Memory, memory);
+
+  WasmWriter exports;
+  exports.U32(4);
+  for (uint32_t i = 0; i < 4; ++i) {
+    exports.Name(kExportNames[i]);
+    exports.U8(static_cast<uint8_t>(ExternalKind::Func));
+    exports.U32(i);
+  }
+  module.Section(BinarySection::Export, exports);
+
+  WasmWriter code;
+  code.U32(4);
+  WriteLoopBody(&code, true);
+  WriteBulkBody(&code, Opcode::MemoryCopy);
+  WriteLoopBody(&code, false);
+  WriteBulkBody(&code, Opcode::MemoryFill);
+  module.Section(BinarySection::Code, code);
+  return module.data();
+}
+
+// Returns the best ns per call of |handle| over kBytesPerRun bytes in
+// |size|-byte calls, or a negative value if a call fails or doesn't write
+// the last byte. The source bytes are zero, and the fill value isn't.
+double TimeCalls(Executor* executor,
+                 const ExportHandle& handle,
+                 Memory* memory,
+                 bool copy,
+                 uint32_t size) {
+  Value args[3];
+  args[0].i32 = kDst;
+  args[1].i32 = copy ? kSrc : 0x01010101;
+  args[2].i32 = size;
+  uint32_t calls = kBytesPerRun / size;
+  memory->data[kDst + size - 1] = copy ? 1 : 0;
+  double best = 1e9;
+  for (int i = 0; i < kRuns; ++i) {
+    Timer timer;
+    for (uint32_t j = 0; j < calls; ++j) {
+      if (executor->Call(handle, args, nullptr) != interp::Result::Ok)
+        return -1;
+    }
+    best = std::min(best, timer.Seconds());
+  }
+  if (memory->data[kDst + size - 1] != (copy ? 0 : 1))
+    return -1;
+  return best * 1e9 / calls;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  std::vector<uint8_t> module = MakeBulkModule();
+  Environment env;
+  ReadBinaryOptions options;
+  options.features.enable_bulk_memory();
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* defined = nullptr;
+  if (Failed(ReadBinaryInterp(&env, module.data(), module.size(), &options,
+                              &error_handler, &defined))) {
+    fprintf(stderr, "%s", error_handler.buffer().c_str());
+    return 1;
+  }
+
+  Executor executor(&env);
+  ExportHandle handles[4];
+  for (int i = 0; i < 4; ++i) {
+    if (executor.ResolveExport(defined, kExportNames[i], &handles[i]) !=
+        interp::Result::Ok) {
+      return 1;
+    }
+  }
+
+  Memory* memory = env.GetMemory(defined->memory_index);
+  for (uint32_t size : {16, 256, 4096, 65536}) {
+    for (int i = 0; i < 4; i += 2) {
+      bool copy = i == 0;
+      double loop = TimeCalls(&executor, handles[i], memory, copy, size);
+      double bulk = TimeCalls(&executor, handles[i + 1], memory, copy, size);
+      if (loop < 0 || bulk < 0) {
+        fprintf(stderr, "call failed or wrote the wrong bytes\n");
+        return 1;
+      }
+      printf("%5u bytes: %-9s %10.1f ns, %-11s %8.1f ns (%.0fx)\n", size,
+             kExportNames[i], loop, kExportNames[i + 1], bulk, loop / bulk);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Load time of a large module: a cold compile against a code cache hit.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "bench/bench-util.h"
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/code-cache.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+
+using namespace wabt;
+using namespace wabt::bench;
+using namespace wabt::interp;
+
+namespace {
+
+const int kRuns = 10;
+
+// Loads |module| into a new environment, using |cache| if not null; returns
+// the seconds taken, or a negative value on failure.
+double Load(const std::vector<uint8_t>& module,
+            CodeCache* cache,
+            std::vector<uint8_t>* out_istream) {
+  Environment env;
+  ReadBinaryOptions options;
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* defined = nullptr;
+  Timer timer;
+  wabt::Result result =
+      ReadBinaryInterpCached(&env, module.data(), module.size(), &options, 1,
+                             cache, &error_handler, &defined);
+  double seconds = timer.Seconds();
+  if (Failed(result)) {
+    fprintf(stderr, "%s", error_handler.buffer().c_str());
+    return -1;
+  }
+  if (out_istream)
+    *out_istream = env.istream().data;
+  return seconds;
+}
+
+double BestLoad(const std::vector<uint8_t>& module, CodeCache* cache) {
+  double best = 1e9;
+  for (int i = 0; i < kRuns; ++i)
+    best = std::min(best, Load(module, cache, nullptr));
+  return best;
+}
+
+void RemoveDirectory(const std::string& dir) {
+  if (DIR* handle = opendir(dir.c_str())) {
+    while (dirent* entry = readdir(handle)) {
+      std::string name = entry->d_name;
+      if (name != "." && name != "..")
+        remove((dir + "/" + name).c_str());
+    }
+    closedir(handle);
+  }
+  rmdir(dir.c_str());
+}
+
+}  // end anonymous namespace
+
+int main() {
+  char dir_template[] = "/tmp/code-cache-bench-XXXXXX";
+  const char* dir = mkdtemp(dir_template);
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  int status = 0;
+  for (Index num_funcs : {100, 1000, 4000}) {
+    std::vector<uint8_t> module = MakeCodeModule(num_funcs, 100);
+    CodeCache cache(dir);
+    std::vector<uint8_t> cold_istream, cached_istream;
+    // The first cached load compiles and stores the module.
+    if (Load(module, nullptr, &cold_istream) < 0 ||
+        Load(module, &cache, nullptr) < 0 ||
+        Load(module, &cache, &cached_istream) < 0 ||
+        cold_istream != cached_istream) {
+      fprintf(stderr, "cached load failed or differs\n");
+      status = 1;
+      break;
+    }
+
+    double cold = BestLoad(module, nullptr);
+    double hit = BestLoad(module, &cache);
+    printf("%6u funcs, %8zu bytes: compile %8.3f ms, cache hit %8.3f ms "
+           "(%.1fx)\n",
+           num_funcs, module.size(), cold * 1000, hit * 1000, cold / hit);
+  }
+
+  RemoveDirectory(dir);
+  return status;
+}
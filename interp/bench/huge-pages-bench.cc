@@ -0,0 +1,198 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A guest loop doing random loads and stores over a large memory, with and
+// without Environment::set_use_huge_pages, to show the TLB effect.
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "bench/bench-util.h"
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/error-handler.h"
+#include "src/huge-pages.h"
+#include "src/interp.h"
+
+using namespace wabt;
+using namespace wabt::bench;
+using namespace wabt::interp;
+
+namespace {
+
+const int kRuns = 3;
+const uint32_t kAccesses = 1000000;
+
+// (module
+//   (memory <pages>)
+//   (func (export "run") (param $n i32) (result i32) (local $x i32)
+//     (loop
+//       (set_local $x (i32.add (i32.mul (get_local $x)
+//                                       (i32.const 1103515245))
+//                              (i32.const 12345)))
+//       (i32.store (i32.and (get_local $x) (i32.const <size - 4>))
+//                  (i32.add (i32.load (i32.and (get_local $x)
+//                                              (i32.const <size - 4>)))
+//                           (i32.const 1)))
+//       (br_if 0 (tee_local $n (i32.sub (get_local $n) (i32.const 1)))))
+//     (get_local $x)))
+// |pages| must be a power of two.
+std::vector<uint8_t> MakeRandomAccessModule(uint32_t pages) {
+  const int32_t kMask = static_cast<int32_t>(pages * WABT_PAGE_SIZE - 4);
+  WasmWriter module;
+  module.Header();
+
+  WasmWriter types;
+  types.U32(1);
+  types.ValueType(Type::Func);
+  types.U32(1);
+  types.ValueType(Type::I32);
+  types.U32(1);
+  types.ValueType(Type::I32);
+  module.Section(BinarySection::Type, types);
+
+  WasmWriter funcs;
+  funcs.U32(1);
+  funcs.U32(0);
+  module.Section(BinarySection::Function, funcs);
+
+  WasmWriter memory;
+  memory.U32(1);
+  memory.U8(0);
+  memory.U32(pages);
+  module.Section(BinarySection::Memory, memory);
+
+  WasmWriter exports;
+  exports.U32(1);
+  exports.Name("run");
+  exports.U8(static_cast<uint8_t>(ExternalKind::Func));
+  exports.U32(0);
+  module.Section(BinarySection::Export, exports);
+
+  WasmWriter body;
+  body.U32(1);
+  body.U32(1);
+  body.ValueType(Type::I32);
+  body.Op(Opcode::Loop);
+  body.ValueType(Type::Void);
+  body.Op(Opcode::GetLocal);
+  body.U32(1);
+  body.Op(Opcode::I32Const);
+  body.I32(1103515245);
+  body.Op(Opcode::I32Mul);
+  body.Op(Opcode::I32Const);
+  body.I32(12345);
+  body.Op(Opcode::I32Add);
+  body.Op(Opcode::SetLocal);
+  body.U32(1);
+  body.Op(Opcode::GetLocal);
+  body.U32(1);
+  body.Op(Opcode::I32Const);
+  body.I32(kMask);
+  body.Op(Opcode::I32And);
+  body.Op(Opcode::GetLocal);
+  body.U32(1);
+  body.Op(Opcode::I32Const);
+  body.I32(kMask);
+  body.Op(Opcode::I32And);
+  body.Op(Opcode::I32Load);
+  body.U32(2);
+  body.U32(0);
+  body.Op(Opcode::I32Const);
+  body.I32(1);
+  body.Op(Opcode::I32Add);
+  body.Op(Opcode::I32Store);
+  body.U32(2);
+  body.U32(0);
+  body.Op(Opcode::GetLocal);
+  body.U32(0);
+  body.Op(Opcode::I32Const);
+  body.I32(1);
+  body.Op(Opcode::I32Sub);
+  body.Op(Opcode::TeeLocal);
+  body.U32(0);
+  body.Op(Opcode::BrIf);
+  body.U32(0);
+  body.Op(Opcode::End);
+  body.Op(Opcode::GetLocal);
+  body.U32(1);
+  body.Op(Opcode::End);
+
+  WasmWriter code;
+  code.U32(1);
+  code.Sized(body);
+  module.Section(BinarySection::Code, code);
+  return module.data();
+}
+
+// Runs the module's accesses kRuns times after a warm-up run that faults
+// the memory in; returns the best time per access in ns, or a negative
+// value on failure.
+double Run(const std::vector<uint8_t>& module,
+           bool use_huge_pages,
+           size_t* out_huge_page_bytes) {
+  Environment env;
+  env.set_use_huge_pages(use_huge_pages);
+  ReadBinaryOptions options;
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* defined = nullptr;
+  if (Failed(ReadBinaryInterp(&env, module.data(), module.size(), &options,
+                              &error_handler, &defined))) {
+    fprintf(stderr, "%s", error_handler.buffer().c_str());
+    return -1;
+  }
+
+  Executor executor(&env);
+  const Export* run = defined->GetExport("run");
+  Value arg;
+  arg.i32 = kAccesses;
+  double best = 1e9;
+  for (int i = 0; i <= kRuns; ++i) {
+    Timer timer;
+    ExecResult result =
+        executor.RunExport(run, {TypedValue(Type::I32, arg)});
+    if (result.result != interp::Result::Ok)
+      return -1;
+    if (i > 0)
+      best = std::min(best, timer.Seconds());
+  }
+
+  *out_huge_page_bytes =
+      env.GetMemory(defined->memory_index)->data.GetHugePageBytes();
+  return best * 1e9 / kAccesses;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  printf("huge pages %savailable\n", HugePagesAvailable() ? "" : "not ");
+  for (uint32_t pages : {16, 1024, 8192}) {
+    std::vector<uint8_t> module = MakeRandomAccessModule(pages);
+    size_t small_pages_huge_bytes = 0, huge_bytes = 0;
+    double small = Run(module, false, &small_pages_huge_bytes);
+    double huge = Run(module, true, &huge_bytes);
+    if (small < 0 || huge < 0) {
+      fprintf(stderr, "unable to run the module\n");
+      return 1;
+    }
+    printf("%4u MiB memory: %6.1f ns/access (%3zu MiB in huge pages), "
+           "with huge pages %6.1f ns/access (%3zu MiB)\n",
+           pages / 16, small, small_pages_huge_bytes >> 20, huge,
+           huge_bytes >> 20);
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// LEB128 decoding and binary parsing throughput in MB/s.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+
+#include "bench/bench-util.h"
+#include "src/binary-reader-nop.h"
+#include "src/binary-reader.h"
+#include "src/leb128.h"
+
+using namespace wabt;
+using namespace wabt::bench;
+
+namespace {
+
+const int kRuns = 10;
+const int kNumValues = 4000000;
+
+// Keeps the decoding loops from being optimized away.
+volatile uint64_t g_sink;
+
+// Encodes kNumValues values, most of them short, like the indices and
+// immediates in a code section.
+template <typename Write>
+std::vector<uint8_t> MakeLebs(Write write) {
+  std::mt19937_64 random(1);
+  WasmWriter writer;
+  for (int i = 0; i < kNumValues; ++i) {
+    uint64_t value = random();
+    uint64_t bucket = random() % 10;
+    if (bucket < 6)
+      value &= 0x3f;
+    else if (bucket < 8)
+      value &= 0x1fff;
+    else if (bucket < 9)
+      value &= 0xfffffff;
+    write(&writer, value);
+  }
+  return writer.data();
+}
+
+// Decodes every value in |data| with |read|; returns MB/s.
+template <typename T>
+double DecodeRate(const std::vector<uint8_t>& data,
+                  size_t (*read)(const uint8_t*, const uint8_t*, T*)) {
+  double best = 1e9;
+  T sum = 0;
+  for (int i = 0; i < kRuns; ++i) {
+    Timer timer;
+    const uint8_t* p = data.data();
+    const uint8_t* end = p + data.size();
+    while (p < end) {
+      T value;
+      size_t length = read(p, end, &value);
+      if (length == 0)
+        return 0;
+      sum += value;
+      p += length;
+    }
+    best = std::min(best, timer.Seconds());
+  }
+  g_sink = sum;
+  return data.size() / best / 1e6;
+}
+
+double ParseRate(const std::vector<uint8_t>& module) {
+  double best = 1e9;
+  for (int i = 0; i < kRuns; ++i) {
+    BinaryReaderNop reader;
+    ReadBinaryOptions options;
+    Timer timer;
+    if (Failed(ReadBinary(module.data(), module.size(), &reader, &options)))
+      return 0;
+    best = std::min(best, timer.Seconds());
+  }
+  return module.size() / best / 1e6;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  std::vector<uint8_t> u32s = MakeLebs([](WasmWriter* writer, uint64_t value) {
+    writer->U32(static_cast<uint32_t>(value));
+  });
+  std::vector<uint8_t> s32s = MakeLebs([](WasmWriter* writer, uint64_t value) {
+    writer->I32(static_cast<int32_t>(value));
+  });
+  std::vector<uint8_t> s64s = MakeLebs([](WasmWriter* writer, uint64_t value) {
+    writer->I64(static_cast<int64_t>(value));
+  });
+  printf("ReadU32Leb128: %7.1f MB/s\n", DecodeRate(u32s, ReadU32Leb128));
+  printf("ReadS32Leb128: %7.1f MB/s\n", DecodeRate(s32s, ReadS32Leb128));
+  printf("ReadS64Leb128: %7.1f MB/s\n", DecodeRate(s64s, ReadS64Leb128));
+
+  std::vector<uint8_t> module = MakeCodeModule(2000, 100);
+  double rate = ParseRate(module);
+  if (rate == 0) {
+    fprintf(stderr, "unable to parse the module\n");
+    return 1;
+  }
+  printf("ReadBinary (%zu bytes, no validation): %.1f MB/s\n", module.size(),
+         rate);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Time and heap allocations per MB of code for reading, validating and
+// compiling a module with ReadBinaryInterp.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+
+#include "bench/bench-util.h"
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+
+using namespace wabt;
+using namespace wabt::bench;
+using namespace wabt::interp;
+
+// Counts every allocation made through operator new in this program.
+static size_t g_num_allocations;
+
+void* operator new(size_t size) {
+  ++g_num_allocations;
+  if (void* p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+namespace {
+
+const int kRuns = 10;
+
+}  // end anonymous namespace
+
+int main() {
+  for (Index statements : {20, 100, 500}) {
+    const Index kNumFuncs = 2000;
+    std::vector<uint8_t> module = MakeCodeModule(kNumFuncs, statements);
+    double best = 1e9;
+    size_t num_allocations = 0;
+    for (int i = 0; i < kRuns; ++i) {
+      Environment env;
+      ReadBinaryOptions options;
+      ErrorHandlerBuffer error_handler(Location::Type::Binary);
+      DefinedModule* defined = nullptr;
+      size_t start_allocations = g_num_allocations;
+      Timer timer;
+      if (Failed(ReadBinaryInterp(&env, module.data(), module.size(),
+                                  &options, &error_handler, &defined))) {
+        fprintf(stderr, "%s", error_handler.buffer().c_str());
+        return 1;
+      }
+      best = std::min(best, timer.Seconds());
+      num_allocations = g_num_allocations - start_allocations;
+    }
+
+    double megabytes = module.size() / 1e6;
+    printf("%4u statements/func, %8zu bytes: %7.2f ms/MB, %8.0f "
+           "allocations/MB, %6.1f allocations/func\n",
+           statements, module.size(), best * 1000 / megabytes,
+           num_allocations / megabytes,
+           static_cast<double>(num_allocations) / kNumFuncs);
+  }
+  return 0;
+}
@@ -31,6 +31,12 @@
 /* Whether sysconf is defined by unistd.h */
 #define HAVE_SYSCONF 1
 
+/* Whether mmap is defined by sys/mman.h */
+#define HAVE_MMAP 1
+
+/* Whether memfd_create and mremap are defined by sys/mman.h */
+#define HAVE_MEMFD_CREATE 1
+
 /* Whether ssize_t is defined by stddef.h */
 #define HAVE_SSIZE_T 1
 
@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "ImportDelegate.h"
+#include "src/host-view.h"
 
 using namespace wabt;
 using namespace wabt::interp;
@@ -13,6 +14,10 @@ wabt::Result ImportDelegate::ImportFunc(FuncImport* import, Func* func, FuncSign
 	if (import->field_name == "print") {
 		cast<HostFunc>(func)->callback = PrintCallback;
 		return wabt::Result::Ok;
+	} else if (import->field_name == "print_function") {
+		cast<HostFunc>(func)->callback = PrintStringCallback;
+		cast<HostFunc>(func)->pass_context = true;
+		return wabt::Result::Ok;
 	} else if (import->field_name == "import_function") {
 		cast<HostFunc>(func)->callback = MyImportCallback;
 		return wabt::Result::Ok;
@@ -31,7 +36,32 @@ wabt::Result ImportDelegate::ImportTable(TableImport* import, Table* table, cons
 }
 
 wabt::Result ImportDelegate::ImportMemory(MemoryImport* import, Memory* memory, const ErrorCallback& callback) {
-	return wabt::Result::Error;
+	if (import->field_name != "memory") {
+		PrintError(callback, "unknown host memory import " PRIimport,
+				PRINTF_IMPORT_ARG(*import));
+		return wabt::Result::Error;
+	}
+	const Limits& limits = import->limits;
+	if (!arena_) {
+		arena_size_ = (limits.has_max ? limits.max : limits.initial) * WABT_PAGE_SIZE;
+		arena_.reset(static_cast<char*>(calloc(arena_size_ ? arena_size_ : 1, 1)));
+		if (!arena_) {
+			PrintError(callback, "can't allocate host memory " PRIimport,
+					PRINTF_IMPORT_ARG(*import));
+			return wabt::Result::Error;
+		}
+	}
+	size_t initial_size = limits.initial * WABT_PAGE_SIZE;
+	if (initial_size > arena_size_) {
+		PrintError(callback, "host memory " PRIimport " is smaller than its initial size",
+				PRINTF_IMPORT_ARG(*import));
+		return wabt::Result::Error;
+	}
+	memory->page_limits.initial = limits.initial;
+	memory->page_limits.max = arena_size_ / WABT_PAGE_SIZE;
+	memory->page_limits.has_max = true;
+	memory->data = MemoryBuffer::Borrow(arena_.get(), initial_size, arena_size_);
+	return wabt::Result::Ok;
 }
 
 wabt::Result ImportDelegate::ImportGlobal(GlobalImport* import, Global* global, const ErrorCallback& callback) {
@@ -79,6 +109,25 @@ ImportDelegate::InterpResult ImportDelegate::MyImportCallback(const HostFunc* fu
 	return InterpResult::Ok;
 }
 
+// Prints the NUL-terminated string at the address given as the only argument,
+// like print_function in index.html.
+ImportDelegate::InterpResult ImportDelegate::PrintStringCallback(const HostFunc* func, const FuncSignature* sig, Index num_args, TypedValue* args,
+			Index num_results, TypedValue* out_results, void* user_data) {
+	if (num_args != 1 || num_results != 0 || args[0].type != wabt::Type::I32)
+		return InterpResult::ArgumentTypeMismatch;
+
+	auto* context = static_cast<wabt::interp::HostCallContext*>(user_data);
+	wabt::interp::HostMemoryView memory(context->memory);
+	wabt::string_view str;
+	InterpResult result = memory.GetString(args[0].value.i32, &str);
+	if (result != InterpResult::Ok)
+		return result;
+
+	fwrite(str.data(), 1, str.size(), stdout);
+	fputc('\n', stdout);
+	return InterpResult::Ok;
+}
+
 ImportDelegate::InterpResult ImportDelegate::RustUnwindCallback(const HostFunc* func, const FuncSignature* sig, Index num_args, TypedValue* args,
 			Index num_results, TypedValue* out_results, void* user_data) {
 	return InterpResult::Ok;
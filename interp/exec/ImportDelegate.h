@@ -2,6 +2,8 @@
 #ifndef EXEC_IMPORTDELEGATE_H_
 #define EXEC_IMPORTDELEGATE_H_
 
+#include <cstdlib>
+
 #include "src/binary-reader-interp.h"
 #include "src/binary-reader.h"
 #include "src/cast.h"
@@ -42,6 +44,9 @@ private:
 	static InterpResult PrintCallback(const HostFunc* func, const FuncSignature* sig, Index num_args, TypedValue* args,
 			Index num_results, TypedValue* out_results, void* user_data);
 
+	static InterpResult PrintStringCallback(const HostFunc* func, const FuncSignature* sig, Index num_args, TypedValue* args,
+			Index num_results, TypedValue* out_results, void* user_data);
+
 	static InterpResult MyImportCallback(const HostFunc* func, const FuncSignature* sig, Index num_args, TypedValue* args,
 			Index num_results, TypedValue* out_results, void* user_data);
 
@@ -49,6 +54,17 @@ private:
 			Index num_results, TypedValue* out_results, void* user_data);
 
 	void PrintError(const ErrorCallback& callback, const char* format, ...);
+
+	struct FreeDeleter {
+		void operator()(char* data) const { free(data); }
+	};
+
+	// Backs "env.memory": reserved up to the maximum size of the first module
+	// importing it, and shared with the modules importing it later. It comes
+	// from calloc, which maps large blocks without touching them, so the pages
+	// no guest uses cost nothing.
+	std::unique_ptr<char, FreeDeleter> arena_;
+	size_t arena_size_ = 0;
 };
 
 #endif /* EXEC_IMPORTDELEGATE_H_ */
@@ -15,16 +15,25 @@
  */
 
 #include <exec/ImportDelegate.h>
+#include "src/code-cache.h"
+#include "src/huge-pages.h"
+#include "src/mapped-file.h"
+#include "src/snapshot.h"
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 
 using namespace wabt;
 using namespace wabt::interp;
@@ -34,6 +43,14 @@ static const char* s_infile;
 static Thread::Options s_thread_options;
 static Stream* s_trace_stream;
 static Features s_features;
+static bool s_lazy_compile;
+static bool s_stream;
+static int s_compile_threads = 1;
+static std::unique_ptr<CodeCache> s_code_cache;
+static bool s_snapshot;
+static std::string s_init_export;
+static bool s_huge_pages;
+static bool s_lazy_data;
 std::string callExport;
 
 std::unique_ptr<FileStream> s_stdout_stream;
@@ -67,6 +84,40 @@ static void ParseOptions(int argc, char** argv) {
                    });
   parser.AddOption('t', "trace", "Trace execution",
                    []() { s_trace_stream = s_stdout_stream.get(); });
+  parser.AddOption("lazy", "Validate and compile functions on first call",
+                   []() { s_lazy_compile = true; });
+  parser.AddOption('j', "compile-threads", "N",
+                   "Number of threads used to compile function bodies",
+                   [](const std::string& argument) {
+                     s_compile_threads = atoi(argument.c_str());
+                   });
+  parser.AddOption("stream",
+                   "Compile the module while reading it; FILENAME may be - "
+                   "for stdin",
+                   []() { s_stream = true; });
+  parser.AddOption('\0', "code-cache", "DIR",
+                   "Reuse compiled modules cached in DIR",
+                   [](const std::string& argument) {
+                     s_code_cache.reset(new CodeCache(argument));
+                   });
+  parser.AddOption("snapshot",
+                   "Start from FILENAME.snapshot if it is valid; otherwise "
+                   "initialize the module and write it",
+                   []() { s_snapshot = true; });
+  parser.AddOption('\0', "init-export", "NAME",
+                   "With --snapshot, also run export NAME before taking the "
+                   "snapshot",
+                   [](const std::string& argument) {
+                     s_init_export = argument;
+                   });
+  parser.AddOption("huge-pages",
+                   "Back linear memories and code with transparent huge "
+                   "pages where the kernel allows it",
+                   []() { s_huge_pages = true; });
+  parser.AddOption("lazy-data",
+                   "Copy data segments into memory as their pages are first "
+                   "accessed",
+                   []() { s_lazy_data = true; });
 
   parser.AddArgument("filename", OptionParser::ArgumentCount::One,
                      [](const char* argument) { s_infile = argument; });
@@ -74,56 +125,81 @@ static void ParseOptions(int argc, char** argv) {
 }
 
 
-static void RunExport(std::string exportName, interp::Module* module, Executor* executor, RunVerbosity verbose) {
-	for (const interp::Export& export_ : module->exports) {
-		if (export_.name == exportName) {
-			TypedValues args;
-			TypedValues results;
-			Value myValue;
-			myValue.i32 = 41;
-			TypedValue myArg = TypedValue(Type::I32, myValue);
-			args.emplace_back(myArg);
-			ExecResult exec_result = executor->RunExport(&export_, args);
-			for (TypedValue& value : exec_result.values) {
-				switch (value.type) {
-				case Type::I32:
-					std::cout << "export result i32 " << value.value.i32
-							<< "\r\n";
-					break;
-				default:
-					break;
-				}
-
-			}
-			if (verbose == RunVerbosity::Verbose) {
-				WriteCall(s_stdout_stream.get(), string_view(), export_.name,
-						args, exec_result.values, exec_result.result);
-			}
+static void RunExport(string_view exportName, interp::Module* module, Executor* executor, RunVerbosity verbose) {
+	interp::Export* export_ = module->GetExport(exportName);
+	if (!export_)
+		return;
+	TypedValues args;
+	TypedValues results;
+	Value myValue;
+	myValue.i32 = 41;
+	TypedValue myArg = TypedValue(Type::I32, myValue);
+	args.emplace_back(myArg);
+	ExecResult exec_result = executor->RunExport(export_, args);
+	for (TypedValue& value : exec_result.values) {
+		switch (value.type) {
+		case Type::I32:
+			std::cout << "export result i32 " << value.value.i32
+					<< "\r\n";
+			break;
+		default:
+			break;
 		}
 
 	}
+	if (verbose == RunVerbosity::Verbose) {
+		WriteCall(s_stdout_stream.get(), string_view(), export_->name,
+				args, exec_result.values, exec_result.result);
+	}
+}
+
+static wabt::Result ReadModuleStreaming(const char* module_filename, Environment* env, ErrorHandler* error_handler, const ReadBinaryOptions* options, DefinedModule** out_module) {
+	int fd = STDIN_FILENO;
+	if (strcmp(module_filename, "-") != 0) {
+		fd = open(module_filename, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "unable to read file %s: %s\n", module_filename,
+					strerror(errno));
+			return wabt::Result::Error;
+		}
+	}
+
+	wabt::Result result = ReadBinaryInterpFromFd(env, fd, options,
+			error_handler, out_module);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return result;
 }
 
-static wabt::Result ReadModule(const char* module_filename, Environment* env, ErrorHandler* error_handler, DefinedModule** out_module) {
+// |file| must outlive the module when compiling lazily.
+static wabt::Result ReadModule(const char* module_filename, Environment* env, ErrorHandler* error_handler, std::unique_ptr<MappedFile>* file, DefinedModule** out_module) {
 	wabt::Result result;
-	std::vector<uint8_t> file_data;
 
 	*out_module = nullptr;
 
-	result = ReadFile(module_filename, &file_data);
-	if (Succeeded(result)) {
-		const bool kReadDebugNames = true;
-		const bool kStopOnFirstError = true;
-		ReadBinaryOptions options(s_features, s_log_stream.get(),
-				kReadDebugNames, kStopOnFirstError);
-		result = ReadBinaryInterp(env, DataOrNull(file_data), file_data.size(),
-				&options, error_handler, out_module);
+	const bool kReadDebugNames = true;
+	const bool kStopOnFirstError = true;
+	ReadBinaryOptions options(s_features, s_log_stream.get(),
+			kReadDebugNames, kStopOnFirstError);
+	options.defer_function_bodies = s_lazy_compile;
+	options.lazy_data_segments = s_lazy_data;
 
+	if (s_stream) {
+		result = ReadModuleStreaming(module_filename, env, error_handler,
+				&options, out_module);
+	} else {
+		result = MapFile(module_filename, file);
 		if (Succeeded(result)) {
-			if (s_verbose)
-				env->DisassembleModule(s_stdout_stream.get(), *out_module);
+			result = ReadBinaryInterpCached(env, (*file)->data(),
+					(*file)->size(), &options, s_compile_threads,
+					s_code_cache.get(), error_handler, out_module);
 		}
 	}
+
+	if (Succeeded(result)) {
+		if (s_verbose)
+			env->DisassembleModule(s_stdout_stream.get(), *out_module);
+	}
 	return result;
 }
 
@@ -132,22 +208,80 @@ static void InitEnvironment(Environment* env) {
 	host_module->import_delegate.reset(new ImportDelegate());
 }
 
+// Instantiates |module| from its snapshot, or initializes it and writes one.
+static interp::Result InstantiateFromSnapshot(const char* module_filename, const CodeCacheKey& key, Executor* executor, CompiledModule* module, std::unique_ptr<Instance>* out_instance) {
+	std::string snapshot_filename = GetSnapshotPath(module_filename);
+	if (Succeeded(ReadSnapshot(snapshot_filename, key, module)))
+		return executor->Instantiate(module, out_instance);
+
+	interp::Result result = executor->Preinitialize(module, s_init_export,
+			out_instance);
+	if (result == interp::Result::Ok &&
+			Failed(WriteSnapshot(snapshot_filename, key, out_instance->get()))) {
+		fprintf(stderr, "unable to write snapshot %s: %s\n",
+				snapshot_filename.c_str(), strerror(errno));
+	}
+	return result;
+}
+
+static void ReportHugePages(Environment* env) {
+	size_t memory_bytes = 0;
+	for (Index i = 0; i < env->GetMemoryCount(); ++i)
+		memory_bytes += env->GetMemory(i)->data.GetHugePageBytes();
+	const std::vector<uint8_t>& istream = env->istream().data;
+	size_t istream_bytes = GetHugePageBytes(istream.data(), istream.size());
+	s_log_stream->Writef("huge pages: memory %" PRIzd " bytes, code %" PRIzd
+			" bytes\n", memory_bytes, istream_bytes);
+}
+
+static void ReportLazyData(Environment* env) {
+	size_t pending_bytes = 0;
+	for (Index i = 0; i < env->GetMemoryCount(); ++i)
+		pending_bytes += env->GetMemory(i)->data.GetLazyPendingBytes();
+	s_log_stream->Writef("lazy data: %" PRIzd " bytes not accessed\n",
+			pending_bytes);
+}
+
 static wabt::Result ReadAndRunModule(const char* module_filename) {
 	wabt::Result result;
 	Environment env;
+	env.set_use_huge_pages(s_huge_pages);
 	InitEnvironment(&env);
 
+	if (s_snapshot && s_stream) {
+		fprintf(stderr, "--snapshot can't be used with --stream\n");
+		return wabt::Result::Error;
+	}
+
 	ErrorHandlerFile error_handler(Location::Type::Binary);
+	std::unique_ptr<MappedFile> file;
 	DefinedModule* module = nullptr;
-	result = ReadModule(module_filename, &env, &error_handler, &module);
+	Environment::MarkPoint mark = env.Mark();
+	result = ReadModule(module_filename, &env, &error_handler, &file, &module);
 	if (Succeeded(result)) {
 		Executor executor(&env, s_trace_stream, s_thread_options);
-		ExecResult exec_result = executor.RunStartFunction(module);
-		if (exec_result.result == interp::Result::Ok) {
+		std::unique_ptr<CompiledModule> compiled;
+		std::unique_ptr<Instance> instance;
+		interp::Result start_result;
+		if (s_snapshot) {
+			CodeCacheKey key = MakeCodeCacheKey(file->data(), file->size(),
+					s_features, &env, mark);
+			compiled.reset(new CompiledModule(&env, module));
+			start_result = InstantiateFromSnapshot(module_filename, key,
+					&executor, compiled.get(), &instance);
+			executor.set_instance(instance.get());
+		} else {
+			start_result = executor.RunStartFunction(module).result;
+		}
+		if (start_result == interp::Result::Ok) {
 			RunExport(callExport, module, &executor, RunVerbosity::Verbose);
+			if (s_verbose && s_huge_pages)
+				ReportHugePages(&env);
+			if (s_verbose && s_lazy_data)
+				ReportLazyData(&env);
 		} else {
 			WriteResult(s_stdout_stream.get(), "error running start function",
-					exec_result.result);
+					start_result);
 		}
 	}
 	return result;
@@ -16,16 +16,28 @@
 
 #include "src/binary-reader-interp.h"
 
+#include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
+#include <thread>
 #include <vector>
 
+#if HAVE_UNISTD_H
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "src/binary-reader-inl.h"
 #include "src/binary-reader-nop.h"
+#include "src/binary-reader.h"
 #include "src/cast.h"
+#include "src/code-cache.h"
 #include "src/error-handler.h"
 #include "src/interp.h"
+#include "src/make-unique.h"
 #include "src/stream.h"
 #include "src/type-checker.h"
 
@@ -58,15 +70,87 @@ struct ElemSegmentInfo {
 };
 
 struct DataSegmentInfo {
-  DataSegmentInfo(void* dst_data, const void* src_data, IstreamOffset size)
-      : dst_data(dst_data), src_data(src_data), size(size) {}
-
-  void* dst_data;        // Not owned.
-  const void* src_data;  // Not owned.
+  DataSegmentInfo(Address dst_address, Offset src_offset, IstreamOffset size)
+      : dst_address(dst_address), src_offset(src_offset), size(size) {}
+
+  // Address in the module's memory.
+  Address dst_address;
+  // Offset in the module data; a streamed module's buffer may move while it
+  // is being read.
+  Offset src_offset;
   IstreamOffset size;
 };
 
-class BinaryReaderInterp : public BinaryReaderNop {
+struct DeferredBodyInfo {
+  DeferredBodyInfo() = default;
+  DeferredBodyInfo(Offset offset, Offset size) : offset(offset), size(size) {}
+
+  Offset offset = 0;
+  Offset size = 0;
+};
+
+// How bodies reported through OnDeferredFunctionBody are compiled.
+enum class DeferredBodyMode {
+  // Emit a compile_func stub; the body is compiled on its first call.
+  Lazy,
+  // Compile all bodies on a thread pool once the module has been read, then
+  // link them in order.
+  Parallel,
+  // Bodies are loaded from a code cache entry once the module has been read.
+  Cached,
+};
+
+struct CallFixup {
+  CallFixup(IstreamOffset offset, Index func_index)
+      : offset(offset), func_index(func_index) {}
+
+  IstreamOffset offset;
+  Index func_index;  // Module function index.
+};
+
+struct BufferedError {
+  BufferedError(const Location& loc, const std::string& message)
+      : loc(loc), message(message) {}
+
+  Location loc;
+  std::string message;
+};
+
+// A function body compiled on its own for DeferredBodyMode::Parallel. Until
+// it is linked, istream offsets in |code| are relative to the body start.
+struct CompiledBody {
+  std::unique_ptr<OutputBuffer> code;
+  IstreamOffset base = kInvalidIstreamOffset;
+  // Offsets of the fields in |code| that hold a body-relative istream offset.
+  IstreamOffsetVector reloc_offsets;
+  std::vector<CallFixup> call_fixups;
+  std::vector<BufferedError> errors;
+  wabt::Result result = wabt::Result::Ok;
+};
+
+// Collects errors from a worker thread so they can be reported in function
+// order once all bodies are compiled.
+class WorkerErrorCollector : public ErrorHandler {
+ public:
+  explicit WorkerErrorCollector(std::vector<BufferedError>* errors)
+      : ErrorHandler(Location::Type::Binary), errors_(errors) {}
+
+  bool OnError(const Location& loc,
+               const std::string& error,
+               const std::string& source_line,
+               size_t source_line_column_offset) override {
+    errors_->emplace_back(loc, error);
+    return true;
+  }
+
+  size_t source_line_max_length() const override { return 80; }
+
+ private:
+  std::vector<BufferedError>* errors_;
+};
+
+// Final, so the templated ReadBinary can call it without virtual dispatch.
+class BinaryReaderInterp final : public BinaryReaderNop {
  public:
   BinaryReaderInterp(Environment* env,
                      DefinedModule* module,
@@ -77,6 +161,43 @@ class BinaryReaderInterp : public BinaryReaderNop {
 
   std::unique_ptr<OutputBuffer> ReleaseOutputBuffer();
 
+  void set_error_handler(ErrorHandler* error_handler) {
+    error_handler_ = error_handler;
+  }
+
+  void set_deferred_body_mode(DeferredBodyMode mode) {
+    deferred_body_mode_ = mode;
+  }
+
+  void set_lazy_data_segments(bool value) { lazy_data_segments_ = value; }
+
+  // Marks every function with a deferred body as compiled by |compiler|.
+  void SetLazyCompiler(LazyFuncCompiler* compiler);
+
+  // Compiles a body reported earlier through OnDeferredFunctionBody, appending
+  // it to the environment's istream. |data| and |size| are the module bytes.
+  wabt::Result CompileDeferredFunc(Index func_index,
+                                   const void* data,
+                                   size_t size,
+                                   const ReadBinaryOptions* options);
+
+  // Compiles every deferred body on |num_threads| threads and links the
+  // results into the istream. The output is identical to reading the module
+  // without deferring function bodies.
+  wabt::Result CompileDeferredFuncsInParallel(const void* data,
+                                              size_t size,
+                                              const ReadBinaryOptions* options,
+                                              int num_threads);
+
+  // Replaces the deferred bodies with the code from a cache entry. Fails if
+  // the entry doesn't match the module.
+  wabt::Result LoadCachedFuncs(const CodeCacheEntry& entry,
+                               const void* module_data);
+  // Collects what LoadCachedFuncs needs to recreate this module's functions.
+  void GetCodeCacheFuncs(IstreamOffset istream_start,
+                         std::vector<CodeCacheFunc>* out_funcs,
+                         std::vector<Type>* out_types);
+
   // Implement BinaryReader.
   bool OnError(const char* message) override;
 
@@ -132,6 +253,9 @@ class BinaryReaderInterp : public BinaryReaderNop {
 
   wabt::Result OnStartFunction(Index func_index) override;
 
+  wabt::Result OnDeferredFunctionBody(Index index,
+                                      Offset offset,
+                                      Offset size) override;
   wabt::Result BeginFunctionBody(Index index) override;
   wabt::Result OnLocalDeclCount(Index count) override;
   wabt::Result OnLocalDecl(Index decl_index, Index count, Type type) override;
@@ -175,6 +299,9 @@ class BinaryReaderInterp : public BinaryReaderNop {
                           uint32_t alignment_log2,
                           Address offset) override;
   wabt::Result OnLoopExpr(Index num_types, Type* sig_types) override;
+  wabt::Result OnMemoryCopyExpr() override;
+  wabt::Result OnMemoryFillExpr() override;
+  wabt::Result OnMemoryInitExpr(Index segment_index) override;
   wabt::Result OnNopExpr() override;
   wabt::Result OnReturnExpr() override;
   wabt::Result OnSelectExpr() override;
@@ -198,10 +325,16 @@ class BinaryReaderInterp : public BinaryReaderNop {
   wabt::Result OnElemSegmentFunctionIndex(Index index,
                                           Index func_index) override;
 
+  wabt::Result OnDataSegmentCount(Index count) override;
+  wabt::Result BeginDataSegment(Index index,
+                                Index memory_index,
+                                bool passive) override;
   wabt::Result OnDataSegmentData(Index index,
                                  const void* data,
                                  Address size) override;
 
+  wabt::Result OnDataCount(Index count) override;
+
   wabt::Result OnInitExprF32ConstExpr(Index index, uint32_t value) override;
   wabt::Result OnInitExprF64ConstExpr(Index index, uint64_t value) override;
   wabt::Result OnInitExprGetGlobalExpr(Index index,
@@ -240,6 +373,7 @@ class BinaryReaderInterp : public BinaryReaderNop {
   wabt::Result EmitI32(uint32_t value);
   wabt::Result EmitI64(uint64_t value);
   wabt::Result EmitI32At(IstreamOffset offset, uint32_t value);
+  wabt::Result EmitIstreamOffset(IstreamOffset offset);
   wabt::Result EmitDropKeep(uint32_t drop, uint8_t keep);
   wabt::Result AppendFixup(IstreamOffsetVectorVector* fixups_vector,
                            Index index);
@@ -253,6 +387,7 @@ class BinaryReaderInterp : public BinaryReaderNop {
   wabt::Result EmitBrTableOffset(Index depth);
   wabt::Result FixupTopLabel();
   wabt::Result EmitFuncOffset(DefinedFunc* func, Index func_index);
+  void AllocateDataSegments(Index count);
 
   wabt::Result CheckLocal(Index local_index);
   wabt::Result CheckGlobal(Index global_index);
@@ -260,6 +395,7 @@ class BinaryReaderInterp : public BinaryReaderNop {
   wabt::Result CheckImportLimits(const Limits* declared_limits,
                                  const Limits* actual_limits);
   wabt::Result CheckHasMemory(wabt::Opcode opcode);
+  wabt::Result CheckDataSegment(Index segment_index);
   wabt::Result CheckAlign(uint32_t alignment_log2, Address natural_alignment);
   wabt::Result CheckAtomicAlign(uint32_t alignment_log2,
                                 Address natural_alignment);
@@ -276,6 +412,16 @@ class BinaryReaderInterp : public BinaryReaderNop {
 
   HostImportDelegate::ErrorCallback MakePrintErrorCallback();
 
+  std::unique_ptr<BinaryReaderInterp> CreateWorker();
+  wabt::Result CompileRelocatableBody(Index func_index,
+                                      const DeferredBodyInfo& body_info,
+                                      const void* data,
+                                      size_t size,
+                                      const ReadBinaryOptions* options,
+                                      CompiledBody* out_body);
+  wabt::Result LinkCompiledBodies(std::vector<CompiledBody>* bodies);
+  void InitSegments(const void* module_data);
+
   ErrorHandler* error_handler_ = nullptr;
   Environment* env_ = nullptr;
   DefinedModule* module_ = nullptr;
@@ -284,7 +430,7 @@ class BinaryReaderInterp : public BinaryReaderNop {
   std::vector<Label> label_stack_;
   IstreamOffsetVectorVector func_fixups_;
   IstreamOffsetVectorVector depth_fixups_;
-  MemoryStream istream_;
+  std::unique_ptr<MemoryStream> istream_;
   IstreamOffset istream_offset_ = 0;
   /* mappings from module index space to env index space; this won't just be a
    * translation, because imported values will be resolved as well */
@@ -294,6 +440,13 @@ class BinaryReaderInterp : public BinaryReaderNop {
 
   Index num_func_imports_ = 0;
   Index num_global_imports_ = 0;
+  // The module's data segments are env data segments [start, start + count).
+  // The count is kInvalidIndex until the data count or data section is read.
+  Index data_segment_start_ = 0;
+  Index num_data_segments_ = kInvalidIndex;
+  // Whether the module has a data count section; memory.init needs one even
+  // when the data section was read first, as with deferred function bodies.
+  bool has_data_count_ = false;
 
   // Changes to linear memory and tables should not apply if a validation error
   // occurs; these vectors cache the changes that must be applied after we know
@@ -301,9 +454,19 @@ class BinaryReaderInterp : public BinaryReaderNop {
   std::vector<ElemSegmentInfo> elem_segment_infos_;
   std::vector<DataSegmentInfo> data_segment_infos_;
 
+  // Byte ranges of function bodies whose compilation was deferred, indexed by
+  // defined function index.
+  std::vector<DeferredBodyInfo> deferred_bodies_;
+  DeferredBodyMode deferred_body_mode_ = DeferredBodyMode::Lazy;
+  // See ReadBinaryOptions::lazy_data_segments.
+  bool lazy_data_segments_ = false;
+  // Non-null while a worker compiles a body that will be relocated later.
+  CompiledBody* compiled_body_ = nullptr;
+
   // Values cached so they can be shared between callbacks.
   TypedValue init_expr_value_;
   IstreamOffset table_offset_ = 0;
+  bool data_segment_passive_ = false;
 };
 
 BinaryReaderInterp::BinaryReaderInterp(Environment* env,
@@ -313,14 +476,14 @@ BinaryReaderInterp::BinaryReaderInterp(Environment* env,
     : error_handler_(error_handler),
       env_(env),
       module_(module),
-      istream_(std::move(istream)),
-      istream_offset_(istream_.output_buffer().size()) {
+      istream_(MakeUnique<MemoryStream>(std::move(istream))),
+      istream_offset_(istream_->output_buffer().size()) {
   typechecker_.set_error_callback(
       [this](const char* msg) { PrintError("%s", msg); });
 }
 
 std::unique_ptr<OutputBuffer> BinaryReaderInterp::ReleaseOutputBuffer() {
-  return istream_.ReleaseOutputBuffer();
+  return istream_->ReleaseOutputBuffer();
 }
 
 Label* BinaryReaderInterp::GetLabel(Index depth) {
@@ -389,8 +552,8 @@ IstreamOffset BinaryReaderInterp::GetIstreamOffset() {
 wabt::Result BinaryReaderInterp::EmitDataAt(IstreamOffset offset,
                                             const void* data,
                                             IstreamOffset size) {
-  istream_.WriteDataAt(offset, data, size);
-  return istream_.result();
+  istream_->WriteDataAt(offset, data, size);
+  return istream_->result();
 }
 
 wabt::Result BinaryReaderInterp::EmitData(const void* data,
@@ -428,6 +591,12 @@ wabt::Result BinaryReaderInterp::EmitI32At(IstreamOffset offset,
   return EmitDataAt(offset, &value, sizeof(value));
 }
 
+wabt::Result BinaryReaderInterp::EmitIstreamOffset(IstreamOffset offset) {
+  if (compiled_body_)
+    compiled_body_->reloc_offsets.push_back(GetIstreamOffset());
+  return EmitI32(offset);
+}
+
 wabt::Result BinaryReaderInterp::EmitDropKeep(uint32_t drop, uint8_t keep) {
   assert(drop != UINT32_MAX);
   assert(keep <= 1);
@@ -460,7 +629,7 @@ wabt::Result BinaryReaderInterp::EmitBrOffset(Index depth,
     depth = label_stack_.size() - 1 - depth;
     CHECK_RESULT(AppendFixup(&depth_fixups_, depth));
   }
-  CHECK_RESULT(EmitI32(offset));
+  CHECK_RESULT(EmitIstreamOffset(offset));
   return wabt::Result::Ok;
 }
 
@@ -524,6 +693,11 @@ wabt::Result BinaryReaderInterp::FixupTopLabel() {
 
 wabt::Result BinaryReaderInterp::EmitFuncOffset(DefinedFunc* func,
                                                 Index func_index) {
+  if (compiled_body_) {
+    /* Other bodies may still be compiling, so don't read their offsets. */
+    compiled_body_->call_fixups.emplace_back(GetIstreamOffset(), func_index);
+    return EmitI32(kInvalidIstreamOffset);
+  }
   if (func->offset == kInvalidIstreamOffset) {
     Index defined_index = TranslateModuleFuncIndexToDefined(func_index);
     CHECK_RESULT(AppendFixup(&func_fixups_, defined_index));
@@ -675,9 +849,9 @@ wabt::Result BinaryReaderInterp::OnImportFunc(Index import_index,
 
   Index func_env_index;
   if (auto* host_import_module = dyn_cast<HostModule>(import_module)) {
-    HostFunc* func = new HostFunc(import->module_name, import->field_name,
-                                  import->sig_index);
-    env_->EmplaceBackFunc(func);
+    HostFunc* func = env_->EmplaceBackHostFunc(
+        import->module_name, import->field_name, import->sig_index);
+    func->importer = module_;
 
     FuncSignature* sig = env_->GetFuncSignature(func->sig_index);
     CHECK_RESULT(host_import_module->import_delegate->ImportFunc(
@@ -766,10 +940,19 @@ wabt::Result BinaryReaderInterp::OnImportMemory(Index import_index,
   if (auto* host_import_module = dyn_cast<HostModule>(import_module)) {
     Memory* memory = env_->EmplaceBackMemory();
 
+    import->limits = *page_limits;
     CHECK_RESULT(host_import_module->import_delegate->ImportMemory(
         import, memory, MakePrintErrorCallback()));
 
     CHECK_RESULT(CheckImportLimits(page_limits, &memory->page_limits));
+    uint64_t size = memory->page_limits.initial * WABT_PAGE_SIZE;
+    if (memory->data.size() == 0) {
+      memory->data.resize(size);
+    } else if (memory->data.size() != size) {
+      PrintError("host memory has %" PRIzd " bytes; its limits say %" PRIu64,
+                 memory->data.size(), size);
+      return wabt::Result::Error;
+    }
 
     module_->memory_index = env_->GetMemoryCount() - 1;
     AppendExport(host_import_module, ExternalKind::Memory,
@@ -833,7 +1016,7 @@ wabt::Result BinaryReaderInterp::OnFunctionCount(Index count) {
 }
 
 wabt::Result BinaryReaderInterp::OnFunction(Index index, Index sig_index) {
-  env_->EmplaceBackFunc(new DefinedFunc(TranslateSigIndexToEnv(sig_index)));
+  env_->EmplaceBackDefinedFunc(TranslateSigIndexToEnv(sig_index));
   return wabt::Result::Ok;
 }
 
@@ -846,6 +1029,7 @@ wabt::Result BinaryReaderInterp::OnTable(Index index,
   }
   env_->EmplaceBackTable(*elem_limits);
   module_->table_index = env_->GetTableCount() - 1;
+  module_->defined_table_index = module_->table_index;
   return wabt::Result::Ok;
 }
 
@@ -855,12 +1039,26 @@ wabt::Result BinaryReaderInterp::OnMemory(Index index,
     PrintError("only one memory allowed");
     return wabt::Result::Error;
   }
-  env_->EmplaceBackMemory(*page_limits);
+  if (lazy_data_segments_) {
+    // Start from an untouched mapping rather than a zeroed heap block.
+    Memory* memory = env_->EmplaceBackMemory();
+    memory->page_limits = *page_limits;
+    uint64_t max_pages =
+        page_limits->has_max ? page_limits->max : WABT_MAX_PAGES;
+    memory->data.UseLazyMapping(
+        page_limits->initial * WABT_PAGE_SIZE,
+        std::min<uint64_t>(max_pages * WABT_PAGE_SIZE, SIZE_MAX / 2));
+  } else {
+    env_->EmplaceBackMemory(*page_limits);
+  }
   module_->memory_index = env_->GetMemoryCount() - 1;
+  module_->defined_memory_index = module_->memory_index;
   return wabt::Result::Ok;
 }
 
 wabt::Result BinaryReaderInterp::OnGlobalCount(Index count) {
+  module_->defined_global_start = env_->GetGlobalCount();
+  module_->defined_global_count = count;
   for (Index i = 0; i < count; ++i)
     global_index_mapping_.push_back(env_->GetGlobalCount() + i);
   return wabt::Result::Ok;
@@ -1009,9 +1207,42 @@ wabt::Result BinaryReaderInterp::OnElemSegmentFunctionIndex(Index index,
   return wabt::Result::Ok;
 }
 
+void BinaryReaderInterp::AllocateDataSegments(Index count) {
+  data_segment_start_ = env_->GetDataSegmentCount();
+  num_data_segments_ = count;
+  for (Index i = 0; i < count; ++i)
+    env_->EmplaceBackDataSegment();
+}
+
+wabt::Result BinaryReaderInterp::OnDataCount(Index count) {
+  has_data_count_ = true;
+  AllocateDataSegments(count);
+  return wabt::Result::Ok;
+}
+
+wabt::Result BinaryReaderInterp::OnDataSegmentCount(Index count) {
+  // The binary reader checked that this matches the data count section.
+  if (num_data_segments_ == kInvalidIndex)
+    AllocateDataSegments(count);
+  return wabt::Result::Ok;
+}
+
+wabt::Result BinaryReaderInterp::BeginDataSegment(Index index,
+                                                  Index memory_index,
+                                                  bool passive) {
+  data_segment_passive_ = passive;
+  return wabt::Result::Ok;
+}
+
 wabt::Result BinaryReaderInterp::OnDataSegmentData(Index index,
                                                    const void* src_data,
                                                    Address size) {
+  if (data_segment_passive_) {
+    *env_->GetDataSegment(data_segment_start_ + index) =
+        DataSegment(src_data, size);
+    return wabt::Result::Ok;
+  }
+
   assert(module_->memory_index != kInvalidIndex);
   Memory* memory = env_->GetMemory(module_->memory_index);
   assert(init_expr_value_.type == Type::I32);
@@ -1025,25 +1256,90 @@ wabt::Result BinaryReaderInterp::OnDataSegmentData(Index index,
     return wabt::Result::Error;
   }
 
-  if (size > 0)
-    data_segment_infos_.emplace_back(&memory->data[address], src_data, size);
+  if (size > 0) {
+    Offset src_offset = static_cast<const uint8_t*>(src_data) - state->data;
+    data_segment_infos_.emplace_back(address, src_offset, size);
+  }
 
   return wabt::Result::Ok;
 }
 
+wabt::Result BinaryReaderInterp::OnDeferredFunctionBody(Index index,
+                                                        Offset offset,
+                                                        Offset size) {
+  auto* func = cast<DefinedFunc>(GetFuncByModuleIndex(index));
+  Index defined_index = TranslateModuleFuncIndexToDefined(index);
+  if (defined_index >= deferred_bodies_.size())
+    deferred_bodies_.resize(defined_index + 1);
+  deferred_bodies_[defined_index] = DeferredBodyInfo(offset, size);
+  if (deferred_body_mode_ != DeferredBodyMode::Lazy)
+    return wabt::Result::Ok;
+
+  /* The stub is patched into a br to the real body once it is compiled, so
+   * callers can keep calling the stub offset. */
+  func->offset = GetIstreamOffset();
+  CHECK_RESULT(EmitOpcode(Opcode::InterpCompileFunc));
+  CHECK_RESULT(EmitI32(TranslateFuncIndexToEnv(index)));
+  return wabt::Result::Ok;
+}
+
+void BinaryReaderInterp::SetLazyCompiler(LazyFuncCompiler* compiler) {
+  for (Index i = 0; i < deferred_bodies_.size(); ++i) {
+    Index func_index = TranslateFuncIndexToEnv(num_func_imports_ + i);
+    cast<DefinedFunc>(env_->GetFunc(func_index))->lazy_compiler = compiler;
+  }
+}
+
+wabt::Result BinaryReaderInterp::CompileDeferredFunc(
+    Index func_index,
+    const void* data,
+    size_t size,
+    const ReadBinaryOptions* options) {
+  auto* func = cast<DefinedFunc>(env_->GetFunc(func_index));
+  assert(func->lazy_compiler);
+  /* Defined functions are contiguous in the environment. */
+  Index module_func_index =
+      func_index - TranslateFuncIndexToEnv(num_func_imports_) +
+      num_func_imports_;
+  const DeferredBodyInfo& body =
+      deferred_bodies_[TranslateModuleFuncIndexToDefined(module_func_index)];
+  IstreamOffset stub_offset = func->offset;
+
+  istream_ = MakeUnique<MemoryStream>(env_->ReleaseIstream());
+  IstreamOffset istream_size = istream_->output_buffer().size();
+  istream_offset_ = istream_size;
+
+  wabt::Result result = ReadBinaryFunctionBody(
+      data, size, module_func_index, body.offset, body.size,
+      func_index_mapping_.size(), sig_index_mapping_.size(), this, options);
+  if (Succeeded(result)) {
+    uint8_t br = Opcode(Opcode::Br).GetCode();
+    result |= EmitDataAt(stub_offset, &br, sizeof(br));
+    result |= EmitI32At(stub_offset + sizeof(br), func->offset);
+  }
+
+  std::unique_ptr<OutputBuffer> istream = ReleaseOutputBuffer();
+  if (Succeeded(result)) {
+    func->lazy_compiler = nullptr;
+  } else {
+    /* Leave the stub in place so the next call reports the error again. */
+    istream->data.resize(istream_size);
+    func->offset = stub_offset;
+    func->param_and_local_types.clear();
+  }
+  env_->SetIstream(std::move(istream));
+  return result;
+}
+
 void BinaryReaderInterp::PushLabel(IstreamOffset offset,
                                    IstreamOffset fixup_offset) {
   label_stack_.emplace_back(offset, fixup_offset);
 }
 
 void BinaryReaderInterp::PopLabel() {
+  /* FixupTopLabel has emptied the label's depth_fixups_ entry; it is kept,
+   * with its capacity, for the next label at this depth. */
   label_stack_.pop_back();
-  /* reduce the depth_fixups_ stack as well, but it may be smaller than
-   * label_stack_ so only do it conditionally. */
-  if (depth_fixups_.size() > label_stack_.size()) {
-    depth_fixups_.erase(depth_fixups_.begin() + label_stack_.size(),
-                        depth_fixups_.end());
-  }
 }
 
 wabt::Result BinaryReaderInterp::BeginFunctionBody(Index index) {
@@ -1055,14 +1351,17 @@ wabt::Result BinaryReaderInterp::BeginFunctionBody(Index index) {
   func->local_count = 0;
 
   current_func_ = func;
-  depth_fixups_.clear();
+  for (IstreamOffsetVector& fixups : depth_fixups_)
+    fixups.clear();
   label_stack_.clear();
 
-  /* fixup function references */
-  Index defined_index = TranslateModuleFuncIndexToDefined(index);
-  IstreamOffsetVector& fixups = func_fixups_[defined_index];
-  for (IstreamOffset fixup : fixups)
-    CHECK_RESULT(EmitI32At(fixup, func->offset));
+  /* fixup function references; relocatable bodies are fixed up when linked */
+  if (!compiled_body_) {
+    Index defined_index = TranslateModuleFuncIndexToDefined(index);
+    IstreamOffsetVector& fixups = func_fixups_[defined_index];
+    for (IstreamOffset fixup : fixups)
+      CHECK_RESULT(EmitI32At(fixup, func->offset));
+  }
 
   /* append param types */
   for (Type param_type : sig->param_types)
@@ -1116,6 +1415,19 @@ wabt::Result BinaryReaderInterp::CheckHasMemory(wabt::Opcode opcode) {
   return wabt::Result::Ok;
 }
 
+wabt::Result BinaryReaderInterp::CheckDataSegment(Index segment_index) {
+  if (!has_data_count_) {
+    PrintError("memory.init requires a data count section");
+    return wabt::Result::Error;
+  }
+  if (segment_index >= num_data_segments_) {
+    PrintError("invalid data segment index: %" PRIindex " (max %" PRIindex ")",
+               segment_index, num_data_segments_);
+    return wabt::Result::Error;
+  }
+  return wabt::Result::Ok;
+}
+
 wabt::Result BinaryReaderInterp::CheckAlign(uint32_t alignment_log2,
                                             Address natural_alignment) {
   if (alignment_log2 >= 32 || (1U << alignment_log2) > natural_alignment) {
@@ -1197,25 +1509,22 @@ wabt::Result BinaryReaderInterp::OnBinaryExpr(wabt::Opcode opcode) {
 }
 
 wabt::Result BinaryReaderInterp::OnBlockExpr(Index num_types, Type* sig_types) {
-  TypeVector sig(sig_types, sig_types + num_types);
-  CHECK_RESULT(typechecker_.OnBlock(&sig));
+  CHECK_RESULT(typechecker_.OnBlock(num_types, sig_types));
   PushLabel(kInvalidIstreamOffset, kInvalidIstreamOffset);
   return wabt::Result::Ok;
 }
 
 wabt::Result BinaryReaderInterp::OnLoopExpr(Index num_types, Type* sig_types) {
-  TypeVector sig(sig_types, sig_types + num_types);
-  CHECK_RESULT(typechecker_.OnLoop(&sig));
+  CHECK_RESULT(typechecker_.OnLoop(num_types, sig_types));
   PushLabel(GetIstreamOffset(), kInvalidIstreamOffset);
   return wabt::Result::Ok;
 }
 
 wabt::Result BinaryReaderInterp::OnIfExpr(Index num_types, Type* sig_types) {
-  TypeVector sig(sig_types, sig_types + num_types);
-  CHECK_RESULT(typechecker_.OnIf(&sig));
+  CHECK_RESULT(typechecker_.OnIf(num_types, sig_types));
   CHECK_RESULT(EmitOpcode(Opcode::InterpBrUnless));
   IstreamOffset fixup_offset = GetIstreamOffset();
-  CHECK_RESULT(EmitI32(kInvalidIstreamOffset));
+  CHECK_RESULT(EmitIstreamOffset(kInvalidIstreamOffset));
   PushLabel(kInvalidIstreamOffset, fixup_offset);
   return wabt::Result::Ok;
 }
@@ -1226,7 +1535,7 @@ wabt::Result BinaryReaderInterp::OnElseExpr() {
   IstreamOffset fixup_cond_offset = label->fixup_offset;
   CHECK_RESULT(EmitOpcode(Opcode::Br));
   label->fixup_offset = GetIstreamOffset();
-  CHECK_RESULT(EmitI32(kInvalidIstreamOffset));
+  CHECK_RESULT(EmitIstreamOffset(kInvalidIstreamOffset));
   CHECK_RESULT(EmitI32At(fixup_cond_offset, GetIstreamOffset()));
   return wabt::Result::Ok;
 }
@@ -1259,7 +1568,7 @@ wabt::Result BinaryReaderInterp::OnBrIfExpr(Index depth) {
   /* flip the br_if so if <cond> is true it can drop values from the stack */
   CHECK_RESULT(EmitOpcode(Opcode::InterpBrUnless));
   IstreamOffset fixup_br_offset = GetIstreamOffset();
-  CHECK_RESULT(EmitI32(kInvalidIstreamOffset));
+  CHECK_RESULT(EmitIstreamOffset(kInvalidIstreamOffset));
   CHECK_RESULT(EmitBr(depth, drop_count, keep_count));
   CHECK_RESULT(EmitI32At(fixup_br_offset, GetIstreamOffset()));
   return wabt::Result::Ok;
@@ -1272,7 +1581,7 @@ wabt::Result BinaryReaderInterp::OnBrTableExpr(Index num_targets,
   CHECK_RESULT(EmitOpcode(Opcode::BrTable));
   CHECK_RESULT(EmitI32(num_targets));
   IstreamOffset fixup_table_offset = GetIstreamOffset();
-  CHECK_RESULT(EmitI32(kInvalidIstreamOffset));
+  CHECK_RESULT(EmitIstreamOffset(kInvalidIstreamOffset));
   /* not necessary for the interp, but it makes it easier to disassemble.
    * This opcode specifies how many bytes of data follow. */
   CHECK_RESULT(EmitOpcode(Opcode::InterpData));
@@ -1429,6 +1738,32 @@ wabt::Result BinaryReaderInterp::OnGrowMemoryExpr() {
   return wabt::Result::Ok;
 }
 
+wabt::Result BinaryReaderInterp::OnMemoryCopyExpr() {
+  CHECK_RESULT(CheckHasMemory(wabt::Opcode::MemoryCopy));
+  CHECK_RESULT(typechecker_.OnMemoryCopy());
+  CHECK_RESULT(EmitOpcode(Opcode::MemoryCopy));
+  CHECK_RESULT(EmitI32(module_->memory_index));
+  return wabt::Result::Ok;
+}
+
+wabt::Result BinaryReaderInterp::OnMemoryFillExpr() {
+  CHECK_RESULT(CheckHasMemory(wabt::Opcode::MemoryFill));
+  CHECK_RESULT(typechecker_.OnMemoryFill());
+  CHECK_RESULT(EmitOpcode(Opcode::MemoryFill));
+  CHECK_RESULT(EmitI32(module_->memory_index));
+  return wabt::Result::Ok;
+}
+
+wabt::Result BinaryReaderInterp::OnMemoryInitExpr(Index segment_index) {
+  CHECK_RESULT(CheckHasMemory(wabt::Opcode::MemoryInit));
+  CHECK_RESULT(CheckDataSegment(segment_index));
+  CHECK_RESULT(typechecker_.OnMemoryInit());
+  CHECK_RESULT(EmitOpcode(Opcode::MemoryInit));
+  CHECK_RESULT(EmitI32(module_->memory_index));
+  CHECK_RESULT(EmitI32(data_segment_start_ + segment_index));
+  return wabt::Result::Ok;
+}
+
 wabt::Result BinaryReaderInterp::OnLoadExpr(wabt::Opcode opcode,
                                             uint32_t alignment_log2,
                                             Address offset) {
@@ -1510,24 +1845,220 @@ wabt::Result BinaryReaderInterp::OnWakeExpr(Opcode opcode,
   return wabt::Result::Ok;
 }
 
-wabt::Result BinaryReaderInterp::EndModule() {
+void BinaryReaderInterp::InitSegments(const void* module_data) {
   for (ElemSegmentInfo& info : elem_segment_infos_) {
     *info.dst = info.func_index;
   }
+  if (data_segment_infos_.empty())
+    return;
+
+  // Segments for an imported memory are applied now, since that memory may
+  // already be in use.
+  Memory* memory = env_->GetMemory(module_->memory_index);
+  bool lazy = lazy_data_segments_ &&
+              module_->memory_index == module_->defined_memory_index;
+  std::vector<LazySegment> lazy_segments;
   for (DataSegmentInfo& info : data_segment_infos_) {
-    memcpy(info.dst_data, info.src_data, info.size);
+    const char* src = static_cast<const char*>(module_data) + info.src_offset;
+    if (lazy)
+      lazy_segments.emplace_back(info.dst_address, src, info.size);
+    else
+      memcpy(&memory->data[info.dst_address], src, info.size);
+  }
+  if (lazy)
+    memory->data.SetLazySegments(lazy_segments);
+}
+
+wabt::Result BinaryReaderInterp::EndModule() {
+  // Segments are applied once the function bodies are available.
+  if (deferred_body_mode_ == DeferredBodyMode::Lazy)
+    InitSegments(state->data);
+  return wabt::Result::Ok;
+}
+
+std::unique_ptr<BinaryReaderInterp> BinaryReaderInterp::CreateWorker() {
+  auto worker = MakeUnique<BinaryReaderInterp>(
+      env_, module_, MakeUnique<OutputBuffer>(), nullptr);
+  worker->sig_index_mapping_ = sig_index_mapping_;
+  worker->func_index_mapping_ = func_index_mapping_;
+  worker->global_index_mapping_ = global_index_mapping_;
+  worker->num_func_imports_ = num_func_imports_;
+  worker->num_global_imports_ = num_global_imports_;
+  worker->data_segment_start_ = data_segment_start_;
+  worker->num_data_segments_ = num_data_segments_;
+  worker->has_data_count_ = has_data_count_;
+  return worker;
+}
+
+wabt::Result BinaryReaderInterp::CompileRelocatableBody(
+    Index func_index,
+    const DeferredBodyInfo& body_info,
+    const void* data,
+    size_t size,
+    const ReadBinaryOptions* options,
+    CompiledBody* out_body) {
+  WorkerErrorCollector error_handler(&out_body->errors);
+  error_handler_ = &error_handler;
+  istream_ = MakeUnique<MemoryStream>(MakeUnique<OutputBuffer>());
+  istream_offset_ = 0;
+  compiled_body_ = out_body;
+
+  out_body->result = ReadBinaryFunctionBody(
+      data, size, func_index, body_info.offset, body_info.size,
+      func_index_mapping_.size(), sig_index_mapping_.size(), this, options);
+  out_body->code = ReleaseOutputBuffer();
+
+  compiled_body_ = nullptr;
+  error_handler_ = nullptr;
+  return out_body->result;
+}
+
+wabt::Result BinaryReaderInterp::LinkCompiledBodies(
+    std::vector<CompiledBody>* bodies) {
+  for (Index i = 0; i < bodies->size(); ++i) {
+    CompiledBody& body = (*bodies)[i];
+    auto* func = cast<DefinedFunc>(GetFuncByModuleIndex(num_func_imports_ + i));
+    body.base = GetIstreamOffset();
+    func->offset = body.base;
+    CHECK_RESULT(EmitData(DataOrNull(body.code->data), body.code->size()));
+    for (IstreamOffset reloc : body.reloc_offsets) {
+      uint32_t value;
+      memcpy(&value, &body.code->data[reloc], sizeof(value));
+      if (value == kInvalidIstreamOffset)
+        continue;
+      CHECK_RESULT(EmitI32At(body.base + reloc, body.base + value));
+    }
+  }
+
+  for (CompiledBody& body : *bodies) {
+    for (const CallFixup& fixup : body.call_fixups) {
+      auto* func = cast<DefinedFunc>(GetFuncByModuleIndex(fixup.func_index));
+      CHECK_RESULT(EmitI32At(body.base + fixup.offset, func->offset));
+    }
   }
   return wabt::Result::Ok;
 }
 
-}  // end anonymous namespace
+wabt::Result BinaryReaderInterp::CompileDeferredFuncsInParallel(
+    const void* data,
+    size_t size,
+    const ReadBinaryOptions* options,
+    int num_threads) {
+  std::vector<CompiledBody> bodies(deferred_bodies_.size());
+  std::atomic<Index> next_body(0);
+  auto compile_bodies = [&](BinaryReaderInterp* worker) {
+    for (Index i = next_body++; i < bodies.size(); i = next_body++) {
+      worker->CompileRelocatableBody(num_func_imports_ + i, deferred_bodies_[i],
+                                     data, size, options, &bodies[i]);
+    }
+  };
 
-wabt::Result ReadBinaryInterp(Environment* env,
-                              const void* data,
-                              size_t size,
-                              const ReadBinaryOptions* options,
-                              ErrorHandler* error_handler,
-                              DefinedModule** out_module) {
+  std::vector<std::unique_ptr<BinaryReaderInterp>> workers;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    workers.push_back(CreateWorker());
+    threads.emplace_back(compile_bodies, workers.back().get());
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  /* report errors in function order, as the serial reader would */
+  wabt::Result result = wabt::Result::Ok;
+  for (const CompiledBody& body : bodies) {
+    for (const BufferedError& error : body.errors)
+      error_handler_->OnError(error.loc, error.message, std::string(), 0);
+    if (Failed(body.result)) {
+      result = wabt::Result::Error;
+      if (options->stop_on_first_error)
+        break;
+    }
+  }
+  CHECK_RESULT(result);
+
+  CHECK_RESULT(LinkCompiledBodies(&bodies));
+  InitSegments(data);
+  return wabt::Result::Ok;
+}
+
+wabt::Result BinaryReaderInterp::LoadCachedFuncs(const CodeCacheEntry& entry,
+                                                 const void* module_data) {
+  Index num_defined_funcs = func_index_mapping_.size() - num_func_imports_;
+  if (entry.num_funcs() != num_defined_funcs ||
+      deferred_bodies_.size() != num_defined_funcs) {
+    return wabt::Result::Error;
+  }
+
+  IstreamOffset base = GetIstreamOffset();
+  CHECK_RESULT(EmitData(entry.istream_data(), entry.istream_size()));
+  for (Index i = 0; i < num_defined_funcs; ++i) {
+    const CodeCacheFunc& cached = entry.func(i);
+    auto* func = cast<DefinedFunc>(GetFuncByModuleIndex(num_func_imports_ + i));
+    func->offset = base + cached.offset;
+    func->local_decl_count = cached.local_decl_count;
+    func->local_count = cached.local_count;
+    const Type* types = entry.types(cached);
+    func->param_and_local_types.assign(types, types + cached.types_count);
+  }
+
+  InitSegments(module_data);
+  return wabt::Result::Ok;
+}
+
+void BinaryReaderInterp::GetCodeCacheFuncs(IstreamOffset istream_start,
+                                           std::vector<CodeCacheFunc>* out_funcs,
+                                           std::vector<Type>* out_types) {
+  for (Index i = num_func_imports_; i < func_index_mapping_.size(); ++i) {
+    auto* func = cast<DefinedFunc>(GetFuncByModuleIndex(i));
+    CodeCacheFunc cached;
+    cached.offset = func->offset - istream_start;
+    cached.local_decl_count = func->local_decl_count;
+    cached.local_count = func->local_count;
+    cached.types_start = out_types->size();
+    cached.types_count = func->param_and_local_types.size();
+    out_funcs->push_back(cached);
+    out_types->insert(out_types->end(), func->param_and_local_types.begin(),
+                      func->param_and_local_types.end());
+  }
+}
+
+class LazyFuncCompilerInterp : public LazyFuncCompiler {
+ public:
+  LazyFuncCompilerInterp(std::unique_ptr<BinaryReaderInterp> reader,
+                         const void* data,
+                         size_t size,
+                         const ReadBinaryOptions& options)
+      : reader_(std::move(reader)),
+        data_(data),
+        size_(size),
+        options_(options),
+        error_handler_(Location::Type::Binary) {
+    // The caller's error handler only lives as long as ReadBinaryInterp.
+    reader_->set_error_handler(&error_handler_);
+    reader_->SetLazyCompiler(this);
+  }
+
+  wabt::Result CompileFunc(Index func_index) override {
+    return reader_->CompileDeferredFunc(func_index, data_, size_, &options_);
+  }
+
+ private:
+  std::unique_ptr<BinaryReaderInterp> reader_;
+  const void* data_;  // Not owned.
+  size_t size_;
+  ReadBinaryOptions options_;
+  ErrorHandlerFile error_handler_;
+};
+
+wabt::Result ReadBinaryInterpImpl(Environment* env,
+                                  const void* data,
+                                  size_t size,
+                                  const ReadBinaryOptions* options,
+                                  int num_threads,
+                                  const CodeCacheEntry* cache_entry,
+                                  ErrorHandler* error_handler,
+                                  DefinedModule** out_module,
+                                  std::unique_ptr<BinaryReaderInterp>* out_reader,
+                                  bool* out_cache_mismatch) {
   // Need to mark before taking ownership of env->istream.
   Environment::MarkPoint mark = env->Mark();
 
@@ -1535,16 +2066,49 @@ wabt::Result ReadBinaryInterp(Environment* env,
   IstreamOffset istream_offset = istream->size();
   DefinedModule* module = new DefinedModule();
 
-  BinaryReaderInterp reader(env, module, std::move(istream), error_handler);
+  auto reader = MakeUnique<BinaryReaderInterp>(env, module, std::move(istream),
+                                               error_handler);
   env->EmplaceBackModule(module);
 
-  wabt::Result result = ReadBinary(data, size, &reader, options);
-  env->SetIstream(reader.ReleaseOutputBuffer());
+  reader->set_lazy_data_segments(options->lazy_data_segments);
+
+  // Logging relies on the callback order of a serial read, and lazy bodies
+  // are compiled one at a time anyway.
+  bool parallel = num_threads > 1 && !options->log_stream &&
+                  !options->defer_function_bodies;
+  wabt::Result result;
+  if (cache_entry) {
+    ReadBinaryOptions cached_options = *options;
+    cached_options.defer_function_bodies = true;
+    reader->set_deferred_body_mode(DeferredBodyMode::Cached);
+    result = ReadBinary(data, size, reader.get(), &cached_options);
+    if (Succeeded(result)) {
+      result = reader->LoadCachedFuncs(*cache_entry, data);
+      *out_cache_mismatch = Failed(result);
+    }
+  } else if (parallel) {
+    ReadBinaryOptions parallel_options = *options;
+    parallel_options.defer_function_bodies = true;
+    reader->set_deferred_body_mode(DeferredBodyMode::Parallel);
+    result = ReadBinary(data, size, reader.get(), &parallel_options);
+    if (Succeeded(result)) {
+      result = reader->CompileDeferredFuncsInParallel(
+          data, size, &parallel_options, num_threads);
+    }
+  } else {
+    result = ReadBinary(data, size, reader.get(), options);
+  }
+  env->SetIstream(reader->ReleaseOutputBuffer());
 
   if (Succeeded(result)) {
     module->istream_start = istream_offset;
     module->istream_end = env->istream().size();
+    if (options->defer_function_bodies) {
+      module->lazy_compiler = MakeUnique<LazyFuncCompilerInterp>(
+          std::move(reader), data, size, *options);
+    }
     *out_module = module;
+    *out_reader = std::move(reader);
   } else {
     env->ResetToMarkPoint(mark);
     *out_module = nullptr;
@@ -1552,4 +2116,180 @@ wabt::Result ReadBinaryInterp(Environment* env,
   return result;
 }
 
+}  // end anonymous namespace
+
+wabt::Result ReadBinaryInterp(Environment* env,
+                              const void* data,
+                              size_t size,
+                              const ReadBinaryOptions* options,
+                              ErrorHandler* error_handler,
+                              DefinedModule** out_module) {
+  return ReadBinaryInterpParallel(env, data, size, options, 1, error_handler,
+                                  out_module);
+}
+
+wabt::Result ReadBinaryInterpParallel(Environment* env,
+                                      const void* data,
+                                      size_t size,
+                                      const ReadBinaryOptions* options,
+                                      int num_threads,
+                                      ErrorHandler* error_handler,
+                                      DefinedModule** out_module) {
+  return ReadBinaryInterpCached(env, data, size, options, num_threads, nullptr,
+                                error_handler, out_module);
+}
+
+wabt::Result ReadBinaryInterpCached(Environment* env,
+                                    const void* data,
+                                    size_t size,
+                                    const ReadBinaryOptions* options,
+                                    int num_threads,
+                                    CodeCache* code_cache,
+                                    ErrorHandler* error_handler,
+                                    DefinedModule** out_module) {
+  // Lazily compiled modules contain stubs, which can't be cached.
+  bool use_cache = code_cache && !options->defer_function_bodies &&
+                   !options->log_stream;
+  CodeCacheKey key;
+  std::unique_ptr<CodeCacheEntry> cache_entry;
+  if (use_cache) {
+    key = MakeCodeCacheKey(data, size, options->features, env, env->Mark());
+    cache_entry = code_cache->Lookup(key);
+  }
+
+  std::unique_ptr<BinaryReaderInterp> reader;
+  bool cache_mismatch = false;
+  wabt::Result result = ReadBinaryInterpImpl(
+      env, data, size, options, num_threads, cache_entry.get(), error_handler,
+      out_module, &reader, &cache_mismatch);
+  if (cache_mismatch) {
+    /* Stale or corrupt entry; compile the module and overwrite it. */
+    cache_entry.reset();
+    result = ReadBinaryInterpImpl(env, data, size, options, num_threads,
+                                  nullptr, error_handler, out_module, &reader,
+                                  &cache_mismatch);
+  }
+
+  if (Succeeded(result) && use_cache && !cache_entry) {
+    DefinedModule* module = *out_module;
+    std::vector<CodeCacheFunc> funcs;
+    std::vector<Type> types;
+    reader->GetCodeCacheFuncs(module->istream_start, &funcs, &types);
+    /* Failing to write the cache doesn't affect the loaded module. */
+    code_cache->Store(key, funcs, types,
+                      env->istream().data.data() + module->istream_start,
+                      module->istream_end - module->istream_start);
+  }
+  return result;
+}
+
+class StreamingReaderInterp::Impl {
+ public:
+  Impl(Environment* env,
+       const ReadBinaryOptions* options,
+       ErrorHandler* error_handler)
+      : env_(env),
+        options_(*options),
+        // Need to mark before taking ownership of env->istream.
+        mark_(env->Mark()),
+        module_(new DefinedModule()) {
+    // The module data doesn't outlive the reader, so bodies can't be lazy.
+    options_.defer_function_bodies = false;
+    std::unique_ptr<OutputBuffer> istream = env->ReleaseIstream();
+    istream_offset_ = istream->size();
+    reader_ = MakeUnique<BinaryReaderInterp>(env, module_, std::move(istream),
+                                             error_handler);
+    env->EmplaceBackModule(module_);
+    stream_reader_ = MakeUnique<StreamingBinaryReader>(reader_.get(), &options_);
+  }
+
+  ~Impl() {
+    if (!finished_)
+      Finish(wabt::Result::Error);
+  }
+
+  DefinedModule* Finish(wabt::Result result) {
+    finished_ = true;
+    env_->SetIstream(reader_->ReleaseOutputBuffer());
+    if (Failed(result)) {
+      env_->ResetToMarkPoint(mark_);
+      return nullptr;
+    }
+    module_->istream_start = istream_offset_;
+    module_->istream_end = env_->istream().size();
+    return module_;
+  }
+
+  Environment* env_;
+  ReadBinaryOptions options_;
+  Environment::MarkPoint mark_;
+  DefinedModule* module_;  // Owned by env_.
+  IstreamOffset istream_offset_ = 0;
+  std::unique_ptr<BinaryReaderInterp> reader_;
+  std::unique_ptr<StreamingBinaryReader> stream_reader_;
+  bool finished_ = false;
+};
+
+StreamingReaderInterp::StreamingReaderInterp(Environment* env,
+                                             const ReadBinaryOptions* options,
+                                             ErrorHandler* error_handler)
+    : impl_(new Impl(env, options, error_handler)) {}
+
+StreamingReaderInterp::~StreamingReaderInterp() {}
+
+void StreamingReaderInterp::Reserve(size_t size) {
+  impl_->stream_reader_->Reserve(size);
+}
+
+wabt::Result StreamingReaderInterp::AppendData(const void* data, size_t size) {
+  assert(!impl_->finished_);
+  return impl_->stream_reader_->AppendData(data, size);
+}
+
+wabt::Result StreamingReaderInterp::Finish(DefinedModule** out_module) {
+  assert(!impl_->finished_);
+  wabt::Result result = impl_->stream_reader_->Finish();
+  *out_module = impl_->Finish(result);
+  return result;
+}
+
+#if HAVE_UNISTD_H
+
+wabt::Result ReadBinaryInterpFromFd(Environment* env,
+                                    int fd,
+                                    const ReadBinaryOptions* options,
+                                    ErrorHandler* error_handler,
+                                    DefinedModule** out_module) {
+  StreamingReaderInterp reader(env, options, error_handler);
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    reader.Reserve(st.st_size);
+
+  const size_t kChunkSize = 64 * 1024;
+  std::vector<uint8_t> chunk(kChunkSize);
+  wabt::Result result = wabt::Result::Ok;
+  while (Succeeded(result)) {
+    ssize_t bytes_read = read(fd, chunk.data(), chunk.size());
+    if (bytes_read < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("read failed");
+      result = wabt::Result::Error;
+    } else if (bytes_read == 0) {
+      break;
+    } else {
+      result = reader.AppendData(chunk.data(), bytes_read);
+    }
+  }
+
+  if (Failed(result)) {
+    *out_module = nullptr;
+    return result;
+  }
+  return reader.Finish(out_module);
+}
+
+#endif
+
 }  // namespace wabt
@@ -17,12 +17,15 @@
 #ifndef WABT_BINARY_READER_INTERP_H_
 #define WABT_BINARY_READER_INTERP_H_
 
+#include <memory>
+
 #include "src/common.h"
 
 namespace wabt {
 
 namespace interp {
 
+class CodeCache;
 struct DefinedModule;
 class Environment;
 
@@ -31,6 +34,10 @@ class Environment;
 class ErrorHandler;
 struct ReadBinaryOptions;
 
+// If options->defer_function_bodies is set, function bodies are validated
+// and compiled on their first call instead, and |data| must outlive the
+// returned module. Likewise if options->lazy_data_segments is set, in which
+// case the module's memory is filled from |data| as it is accessed.
 Result ReadBinaryInterp(interp::Environment* env,
                         const void* data,
                         size_t size,
@@ -38,6 +45,61 @@ Result ReadBinaryInterp(interp::Environment* env,
                         ErrorHandler*,
                         interp::DefinedModule** out_module);
 
+// Like ReadBinaryInterp, but validates and compiles function bodies on
+// |num_threads| threads. Falls back to a serial read if num_threads <= 1, or
+// if options->log_stream or options->defer_function_bodies is set.
+Result ReadBinaryInterpParallel(interp::Environment* env,
+                                const void* data,
+                                size_t size,
+                                const ReadBinaryOptions* options,
+                                int num_threads,
+                                ErrorHandler*,
+                                interp::DefinedModule** out_module);
+
+// Like ReadBinaryInterpParallel, but reuses the compiled code from
+// |code_cache| if it has an entry for this module and environment state, and
+// otherwise stores the compiled code there. Function bodies are not parsed or
+// validated on a cache hit. The cache is not used if options->log_stream or
+// options->defer_function_bodies is set.
+Result ReadBinaryInterpCached(interp::Environment* env,
+                              const void* data,
+                              size_t size,
+                              const ReadBinaryOptions* options,
+                              int num_threads,
+                              interp::CodeCache* code_cache,
+                              ErrorHandler*,
+                              interp::DefinedModule** out_module);
+
+// Reads and compiles a module as its bytes arrive; each function body is
+// compiled as soon as it is complete. See StreamingBinaryReader. |env| must
+// not be used until Finish has been called or the reader is destroyed, which
+// discards the partially read module. options->defer_function_bodies and
+// options->lazy_data_segments are ignored.
+class StreamingReaderInterp {
+ public:
+  StreamingReaderInterp(interp::Environment* env,
+                        const ReadBinaryOptions* options,
+                        ErrorHandler*);
+  ~StreamingReaderInterp();
+
+  void Reserve(size_t size);
+  Result AppendData(const void* data, size_t size);
+  Result Finish(interp::DefinedModule** out_module);
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+#if HAVE_UNISTD_H
+// Reads the module from |fd| until EOF, compiling it while reading.
+Result ReadBinaryInterpFromFd(interp::Environment* env,
+                              int fd,
+                              const ReadBinaryOptions* options,
+                              ErrorHandler*,
+                              interp::DefinedModule** out_module);
+#endif
+
 }  // namespace wabt
 
 #endif /* WABT_BINARY_READER_INTERP_H_ */
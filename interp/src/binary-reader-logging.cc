@@ -253,6 +253,15 @@ Result BinaryReaderLogging::OnLocalDecl(Index decl_index,
   return reader_->OnLocalDecl(decl_index, count, type);
 }
 
+Result BinaryReaderLogging::OnDeferredFunctionBody(Index index,
+                                                   Offset offset,
+                                                   Offset size) {
+  LOGF("OnDeferredFunctionBody(index: %" PRIindex ", offset: %" PRIzd
+       ", size: %" PRIzd ")\n",
+       index, offset, size);
+  return reader_->OnDeferredFunctionBody(index, offset, size);
+}
+
 Result BinaryReaderLogging::OnBlockExpr(Index num_types, Type* sig_types) {
   LOGF("OnBlockExpr(sig: ");
   LogTypes(num_types, sig_types);
@@ -336,6 +345,15 @@ Result BinaryReaderLogging::OnTryExpr(Index num_types, Type* sig_types) {
   return reader_->OnTryExpr(num_types, sig_types);
 }
 
+Result BinaryReaderLogging::BeginDataSegment(Index index,
+                                             Index memory_index,
+                                             bool passive) {
+  LOGF("BeginDataSegment(index: %" PRIindex ", memory_index: %" PRIindex
+       ", passive: %s)\n",
+       index, memory_index, passive ? "true" : "false");
+  return reader_->BeginDataSegment(index, memory_index, passive);
+}
+
 Result BinaryReaderLogging::OnDataSegmentData(Index index,
                                               const void* data,
                                               Address size) {
@@ -565,6 +583,9 @@ DEFINE_INDEX_DESC(OnGetGlobalExpr, "index")
 DEFINE_INDEX_DESC(OnGetLocalExpr, "index")
 DEFINE0(OnGrowMemoryExpr)
 DEFINE_LOAD_STORE_OPCODE(OnLoadExpr);
+DEFINE0(OnMemoryCopyExpr)
+DEFINE0(OnMemoryFillExpr)
+DEFINE_INDEX_DESC(OnMemoryInitExpr, "segment_index")
 DEFINE0(OnNopExpr)
 DEFINE_INDEX_DESC(OnRethrowExpr, "depth");
 DEFINE0(OnReturnExpr)
@@ -592,12 +613,15 @@ DEFINE_END(EndElemSection)
 
 DEFINE_BEGIN(BeginDataSection)
 DEFINE_INDEX(OnDataSegmentCount)
-DEFINE_INDEX_INDEX(BeginDataSegment, "index", "memory_index")
 DEFINE_INDEX(BeginDataSegmentInitExpr)
 DEFINE_INDEX(EndDataSegmentInitExpr)
 DEFINE_INDEX(EndDataSegment)
 DEFINE_END(EndDataSection)
 
+DEFINE_BEGIN(BeginDataCountSection)
+DEFINE_INDEX(OnDataCount)
+DEFINE_END(EndDataCountSection)
+
 DEFINE_BEGIN(BeginNamesSection)
 DEFINE_INDEX(OnFunctionNamesCount)
 DEFINE_INDEX(OnLocalNameFunctionCount)
@@ -120,6 +120,9 @@ class BinaryReaderLogging : public BinaryReaderDelegate {
 
   Result BeginCodeSection(Offset size) override;
   Result OnFunctionBodyCount(Index count) override;
+  Result OnDeferredFunctionBody(Index index,
+                                Offset offset,
+                                Offset size) override;
   Result BeginFunctionBody(Index index) override;
   Result OnLocalDeclCount(Index count) override;
   Result OnLocalDecl(Index decl_index, Index count, Type type) override;
@@ -175,6 +178,9 @@ class BinaryReaderLogging : public BinaryReaderDelegate {
                     uint32_t alignment_log2,
                     Address offset) override;
   Result OnLoopExpr(Index num_types, Type* sig_types) override;
+  Result OnMemoryCopyExpr() override;
+  Result OnMemoryFillExpr() override;
+  Result OnMemoryInitExpr(Index segment_index) override;
   Result OnNopExpr() override;
   Result OnRethrowExpr(Index depth) override;
   Result OnReturnExpr() override;
@@ -212,7 +218,9 @@ class BinaryReaderLogging : public BinaryReaderDelegate {
 
   Result BeginDataSection(Offset size) override;
   Result OnDataSegmentCount(Index count) override;
-  Result BeginDataSegment(Index index, Index memory_index) override;
+  Result BeginDataSegment(Index index,
+                          Index memory_index,
+                          bool passive) override;
   Result BeginDataSegmentInitExpr(Index index) override;
   Result EndDataSegmentInitExpr(Index index) override;
   Result OnDataSegmentData(Index index,
@@ -221,6 +229,10 @@ class BinaryReaderLogging : public BinaryReaderDelegate {
   Result EndDataSegment(Index index) override;
   Result EndDataSection() override;
 
+  Result BeginDataCountSection(Offset size) override;
+  Result OnDataCount(Index count) override;
+  Result EndDataCountSection() override;
+
   Result BeginNamesSection(Offset size) override;
   Result OnFunctionNameSubsection(Index index,
                                   uint32_t name_type,
@@ -154,6 +154,11 @@ class BinaryReaderNop : public BinaryReaderDelegate {
   /* Code section */
   Result BeginCodeSection(Offset size) override { return Result::Ok; }
   Result OnFunctionBodyCount(Index count) override { return Result::Ok; }
+  Result OnDeferredFunctionBody(Index index,
+                                Offset offset,
+                                Offset size) override {
+    return Result::Ok;
+  }
   Result BeginFunctionBody(Index index) override { return Result::Ok; }
   Result OnLocalDeclCount(Index count) override { return Result::Ok; }
   Result OnLocalDecl(Index decl_index, Index count, Type type) override {
@@ -235,6 +240,9 @@ class BinaryReaderNop : public BinaryReaderDelegate {
   Result OnLoopExpr(Index num_types, Type* sig_types) override {
     return Result::Ok;
   }
+  Result OnMemoryCopyExpr() override { return Result::Ok; }
+  Result OnMemoryFillExpr() override { return Result::Ok; }
+  Result OnMemoryInitExpr(Index segment_index) override { return Result::Ok; }
   Result OnNopExpr() override { return Result::Ok; }
   Result OnRethrowExpr(Index depth) override { return Result::Ok; }
   Result OnReturnExpr() override { return Result::Ok; }
@@ -278,7 +286,9 @@ class BinaryReaderNop : public BinaryReaderDelegate {
   /* Data section */
   Result BeginDataSection(Offset size) override { return Result::Ok; }
   Result OnDataSegmentCount(Index count) override { return Result::Ok; }
-  Result BeginDataSegment(Index index, Index memory_index) override {
+  Result BeginDataSegment(Index index,
+                          Index memory_index,
+                          bool passive) override {
     return Result::Ok;
   }
   Result BeginDataSegmentInitExpr(Index index) override { return Result::Ok; }
@@ -291,6 +301,11 @@ class BinaryReaderNop : public BinaryReaderDelegate {
   Result EndDataSegment(Index index) override { return Result::Ok; }
   Result EndDataSection() override { return Result::Ok; }
 
+  /* DataCount section */
+  Result BeginDataCountSection(Offset size) override { return Result::Ok; }
+  Result OnDataCount(Index count) override { return Result::Ok; }
+  Result EndDataCountSection() override { return Result::Ok; }
+
   /* Names section */
   Result BeginNamesSection(Offset size) override { return Result::Ok; }
   Result OnFunctionNameSubsection(Index index,
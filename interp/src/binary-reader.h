@@ -45,6 +45,14 @@ struct ReadBinaryOptions {
   Stream* log_stream = nullptr;
   bool read_debug_names = false;
   bool stop_on_first_error = true;
+  // If set, function bodies are not parsed; OnDeferredFunctionBody is called
+  // with the body's byte range instead, and the body can be read later with
+  // ReadBinaryFunctionBody.
+  bool defer_function_bodies = false;
+  // Interpreter only: if set, the data segments of a module that defines its
+  // memory are copied into it as their pages are first accessed, straight
+  // from the module bytes, which must then outlive the memory.
+  bool lazy_data_segments = false;
 };
 
 class BinaryReaderDelegate {
@@ -164,6 +172,11 @@ class BinaryReaderDelegate {
   /* Code section */
   virtual Result BeginCodeSection(Offset size) = 0;
   virtual Result OnFunctionBodyCount(Index count) = 0;
+  /* Only called if ReadBinaryOptions::defer_function_bodies is set. |offset|
+   * is the offset of the local declarations from the start of the module. */
+  virtual Result OnDeferredFunctionBody(Index index,
+                                        Offset offset,
+                                        Offset size) = 0;
   virtual Result BeginFunctionBody(Index index) = 0;
   virtual Result OnLocalDeclCount(Index count) = 0;
   virtual Result OnLocalDecl(Index decl_index, Index count, Type type) = 0;
@@ -221,6 +234,9 @@ class BinaryReaderDelegate {
                             uint32_t alignment_log2,
                             Address offset) = 0;
   virtual Result OnLoopExpr(Index num_types, Type* sig_types) = 0;
+  virtual Result OnMemoryCopyExpr() = 0;
+  virtual Result OnMemoryFillExpr() = 0;
+  virtual Result OnMemoryInitExpr(Index segment_index) = 0;
   virtual Result OnNopExpr() = 0;
   virtual Result OnRethrowExpr(Index depth) = 0;
   virtual Result OnReturnExpr() = 0;
@@ -260,7 +276,9 @@ class BinaryReaderDelegate {
   /* Data section */
   virtual Result BeginDataSection(Offset size) = 0;
   virtual Result OnDataSegmentCount(Index count) = 0;
-  virtual Result BeginDataSegment(Index index, Index memory_index) = 0;
+  virtual Result BeginDataSegment(Index index,
+                                  Index memory_index,
+                                  bool passive) = 0;
   virtual Result BeginDataSegmentInitExpr(Index index) = 0;
   virtual Result EndDataSegmentInitExpr(Index index) = 0;
   virtual Result OnDataSegmentData(Index index,
@@ -269,6 +287,11 @@ class BinaryReaderDelegate {
   virtual Result EndDataSegment(Index index) = 0;
   virtual Result EndDataSection() = 0;
 
+  /* DataCount section */
+  virtual Result BeginDataCountSection(Offset size) = 0;
+  virtual Result OnDataCount(Index count) = 0;
+  virtual Result EndDataCountSection() = 0;
+
   /* Names section */
   virtual Result BeginNamesSection(Offset size) = 0;
   virtual Result OnFunctionNameSubsection(Index index,
@@ -335,6 +358,48 @@ Result ReadBinary(const void* data,
                   BinaryReaderDelegate* reader,
                   const ReadBinaryOptions* options);
 
+// Reads a single function body that was reported by OnDeferredFunctionBody.
+// |data| and |size| describe the whole module, which must still be alive.
+// |num_funcs| and |num_signatures| are the module's total function and
+// signature counts, used to validate call and call_indirect operands.
+Result ReadBinaryFunctionBody(const void* data,
+                              size_t size,
+                              Index func_index,
+                              Offset body_offset,
+                              Offset body_size,
+                              Index num_funcs,
+                              Index num_signatures,
+                              BinaryReaderDelegate* reader,
+                              const ReadBinaryOptions* options);
+
+// Reads a module incrementally as its bytes arrive, e.g. from a pipe or
+// socket. Each section is read once it is complete, and each function body in
+// the code section as soon as its bytes are available, so the delegate sees
+// the same callbacks as with ReadBinary, interleaved with the I/O.
+//
+// Pointers and offsets passed to the delegate refer to data(); pointers are
+// only valid until the next call to AppendData, as the buffer may grow. The
+// first error ends the read, regardless of options->stop_on_first_error.
+// options->defer_function_bodies is not supported.
+class StreamingBinaryReader {
+ public:
+  StreamingBinaryReader(BinaryReaderDelegate* reader,
+                        const ReadBinaryOptions* options);
+  ~StreamingBinaryReader();
+
+  // Avoids reallocating the buffer if the module size is known up front.
+  void Reserve(size_t size);
+  Result AppendData(const void* data, size_t size);
+  // Call once all bytes have been appended; calls EndModule on success.
+  Result Finish();
+
+  const std::vector<uint8_t>& data() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
 size_t ReadU32Leb128(const uint8_t* ptr,
                      const uint8_t* end,
                      uint32_t* out_value);
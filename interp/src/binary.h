@@ -41,7 +41,8 @@
   V(Start, start, 8)                   \
   V(Elem, elem, 9)                     \
   V(Code, code, 10)                    \
-  V(Data, data, 11)
+  V(Data, data, 11)                    \
+  V(DataCount, datacount, 12)
 
 namespace wabt {
 
@@ -53,7 +54,7 @@ enum class BinarySection {
   Invalid,
 
   First = Custom,
-  Last = Data,
+  Last = DataCount,
 };
 /* clang-format on */
 static const int kBinarySectionCount = WABT_ENUM_COUNT(BinarySection);
@@ -65,6 +66,21 @@ static WABT_INLINE const char* GetSectionName(BinarySection sec) {
   return g_section_name[static_cast<size_t>(sec)];
 }
 
+// Known sections must appear in this order, which differs from the order of
+// their codes: the data count section comes before the code section, so that
+// memory.init can be validated in a single pass.
+static WABT_INLINE int GetSectionOrder(BinarySection sec) {
+  switch (sec) {
+    case BinarySection::DataCount:
+      return static_cast<int>(BinarySection::Code);
+    case BinarySection::Code:
+    case BinarySection::Data:
+      return static_cast<int>(sec) + 1;
+    default:
+      return static_cast<int>(sec);
+  }
+}
+
 }  // namespace wabt
 
 #endif /* WABT_BINARY_H_ */
@@ -23,6 +23,127 @@
 
 namespace wabt {
 
+// static
+hash_code BindingHash::Hash(string_view name) {
+  // FNV-1a.
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return static_cast<hash_code>(hash);
+}
+
+Index BindingHash::FindEntry(string_view name, hash_code hash) const {
+  if (slots_.empty())
+    return kInvalidIndex;
+  for (size_t i = hash & SlotMask();; i = (i + 1) & SlotMask()) {
+    const Slot& slot = slots_[i];
+    if (slot.entry == kInvalidIndex)
+      return kInvalidIndex;
+    if (slot.hash == hash && entries_[slot.entry].first == name)
+      return slot.entry;
+  }
+}
+
+size_t BindingHash::FindSlot(Index entry) const {
+  for (size_t i = hashes_[entry] & SlotMask();; i = (i + 1) & SlotMask()) {
+    assert(slots_[i].entry != kInvalidIndex);
+    if (slots_[i].entry == entry)
+      return i;
+  }
+}
+
+size_t BindingHash::count(string_view name) const {
+  if (slots_.empty())
+    return 0;
+  hash_code hash = Hash(name);
+  size_t result = 0;
+  for (size_t i = hash & SlotMask();; i = (i + 1) & SlotMask()) {
+    const Slot& slot = slots_[i];
+    if (slot.entry == kInvalidIndex)
+      return result;
+    if (slot.hash == hash && entries_[slot.entry].first == name)
+      ++result;
+  }
+}
+
+void BindingHash::InsertSlot(hash_code hash, Index entry) {
+  size_t i = hash & SlotMask();
+  while (slots_[i].entry != kInvalidIndex)
+    i = (i + 1) & SlotMask();
+  slots_[i].hash = hash;
+  slots_[i].entry = entry;
+}
+
+void BindingHash::RemoveSlot(size_t hole) {
+  // Backward-shift deletion: move later members of the probe run into the
+  // hole, unless that would put them before their home slot.
+  for (size_t i = (hole + 1) & SlotMask(); slots_[i].entry != kInvalidIndex;
+       i = (i + 1) & SlotMask()) {
+    size_t home = slots_[i].hash & SlotMask();
+    bool home_in_range =
+        hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+    if (!home_in_range) {
+      slots_[hole] = slots_[i];
+      hole = i;
+    }
+  }
+  slots_[hole].entry = kInvalidIndex;
+}
+
+void BindingHash::Grow() {
+  const size_t kMinSlots = 8;
+  size_t new_size = std::max(kMinSlots, slots_.size() * 2);
+  slots_.assign(new_size, Slot{0, kInvalidIndex});
+  for (Index i = 0; i < entries_.size(); ++i)
+    InsertSlot(hashes_[i], i);
+}
+
+BindingHash::iterator BindingHash::emplace(string_view name,
+                                           hash_code hash,
+                                           const Binding& binding) {
+  // Keep the load factor at or below 3/4.
+  if ((entries_.size() + 1) * 4 > slots_.size() * 3)
+    Grow();
+  Index entry = entries_.size();
+  entries_.emplace_back(name.to_string(), binding);
+  hashes_.push_back(hash);
+  InsertSlot(hash, entry);
+  return begin() + entry;
+}
+
+size_t BindingHash::erase(string_view name) {
+  hash_code hash = Hash(name);
+  size_t result = 0;
+  for (auto iter = find(name, hash); iter != end(); iter = find(name, hash)) {
+    erase(iter);
+    ++result;
+  }
+  return result;
+}
+
+BindingHash::iterator BindingHash::erase(const_iterator pos) {
+  Index entry = pos - entries_.cbegin();
+  RemoveSlot(FindSlot(entry));
+
+  Index last = entries_.size() - 1;
+  if (entry != last) {
+    slots_[FindSlot(last)].entry = entry;
+    entries_[entry] = std::move(entries_[last]);
+    hashes_[entry] = hashes_[last];
+  }
+  entries_.pop_back();
+  hashes_.pop_back();
+  return begin() + entry;
+}
+
+void BindingHash::clear() {
+  entries_.clear();
+  hashes_.clear();
+  slots_.clear();
+}
+
 void BindingHash::FindDuplicates(DuplicateCallback callback) const {
   if (size() > 0) {
     ValueTypeVector duplicates;
@@ -40,20 +161,9 @@ Index BindingHash::FindIndex(const Var& var) const {
 
 void BindingHash::CreateDuplicatesVector(
     ValueTypeVector* out_duplicates) const {
-  // This relies on the fact that in an unordered_multimap, all values with the
-  // same key are adjacent in iteration order.
-  auto first = begin();
-  bool is_first = true;
-  for (auto iter = std::next(first); iter != end(); ++iter) {
-    if (first->first == iter->first) {
-      if (is_first)
-        out_duplicates->push_back(&*first);
-      out_duplicates->push_back(&*iter);
-      is_first = false;
-    } else {
-      is_first = true;
-      first = iter;
-    }
+  for (const value_type& value : entries_) {
+    if (count(value.first) > 1)
+      out_duplicates->push_back(&value);
   }
 }
 
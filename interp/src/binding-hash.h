@@ -19,10 +19,11 @@
 
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
 #include "src/common.h"
+#include "src/hash-util.h"
 #include "src/string-view.h"
 
 namespace wabt {
@@ -37,34 +38,95 @@ struct Binding {
   Index index;
 };
 
-// This class derives from a C++ container, which is usually not advisable
-// because they don't have virtual destructors. So don't delete a BindingHash
-// object through a pointer to std::unordered_multimap.
-class BindingHash : public std::unordered_multimap<std::string, Binding> {
+// A hash multimap from names to bindings, using open addressing. Entries are
+// stored densely in a vector; erasing one moves the last entry into its place.
+// A power-of-two table of (hash, entry index) slots is probed linearly.
+// Lookups take a string_view and, optionally, its precomputed hash, so
+// resolving a name never allocates.
+class BindingHash {
  public:
+  typedef std::pair<std::string, Binding> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
   typedef std::function<void(const value_type&, const value_type&)>
       DuplicateCallback;
 
+  static hash_code Hash(string_view name);
+
+  bool empty() const { return entries_.empty(); }
+  size_t size() const { return entries_.size(); }
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  iterator find(string_view name) { return find(name, Hash(name)); }
+  iterator find(string_view name, hash_code hash) {
+    Index entry = FindEntry(name, hash);
+    return entry == kInvalidIndex ? end() : begin() + entry;
+  }
+  const_iterator find(string_view name) const {
+    return find(name, Hash(name));
+  }
+  const_iterator find(string_view name, hash_code hash) const {
+    Index entry = FindEntry(name, hash);
+    return entry == kInvalidIndex ? end() : begin() + entry;
+  }
+  size_t count(string_view name) const;
+
+  iterator emplace(string_view name, const Binding& binding) {
+    return emplace(name, Hash(name), binding);
+  }
+  iterator emplace(string_view name, hash_code hash, const Binding&);
+
+  // Erases every binding of |name|; returns how many there were.
+  size_t erase(string_view name);
+  // Returns an iterator to the entry that took the erased one's place.
+  iterator erase(const_iterator);
+  void clear();
+
   void FindDuplicates(DuplicateCallback callback) const;
 
   Index FindIndex(const Var&) const;
 
   Index FindIndex(const std::string& name) const {
-    auto iter = find(name);
-    return iter != end() ? iter->second.index : kInvalidIndex;
+    return FindIndex(string_view(name));
   }
 
   Index FindIndex(string_view name) const {
-    return FindIndex(name.to_string());
+    return FindIndex(name, Hash(name));
+  }
+
+  Index FindIndex(string_view name, hash_code hash) const {
+    Index entry = FindEntry(name, hash);
+    return entry != kInvalidIndex ? entries_[entry].second.index
+                                  : kInvalidIndex;
   }
 
  private:
   typedef std::vector<const value_type*> ValueTypeVector;
 
+  struct Slot {
+    hash_code hash;
+    Index entry;  // kInvalidIndex if the slot is empty.
+  };
+
+  size_t SlotMask() const { return slots_.size() - 1; }
+  Index FindEntry(string_view name, hash_code hash) const;
+  size_t FindSlot(Index entry) const;
+  void InsertSlot(hash_code hash, Index entry);
+  void RemoveSlot(size_t slot);
+  void Grow();
+
   void CreateDuplicatesVector(ValueTypeVector* out_duplicates) const;
   void SortDuplicatesVectorByLocation(ValueTypeVector* duplicates) const;
   void CallCallbacks(const ValueTypeVector& duplicates,
                      DuplicateCallback callback) const;
+
+  std::vector<value_type> entries_;
+  std::vector<hash_code> hashes_;  // Parallel to |entries_|.
+  std::vector<Slot> slots_;
 };
 
 }  // namespace wabt
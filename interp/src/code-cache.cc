@@ -0,0 +1,270 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/code-cache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "src/feature.h"
+#include "src/opcode.h"
+
+namespace wabt {
+namespace interp {
+
+namespace {
+
+const char kCodeCacheMagic[4] = {'W', 'S', 'C', 'C'};
+
+/* Cache file layout: header, funcs, types, then the istream bytes. */
+struct CodeCacheHeader {
+  char magic[4];
+  uint32_t version;
+  CodeCacheKey key;
+  uint32_t num_funcs;
+  uint32_t num_types;
+  uint64_t istream_size;
+};
+
+WABT_STATIC_ASSERT(sizeof(Type) == sizeof(int32_t));
+
+/* 64-bit FNV-1a. */
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= UINT64_C(0x100000001b3);
+  }
+  return hash;
+}
+
+const uint64_t kHashSeed = UINT64_C(0xcbf29ce484222325);
+
+template <typename T>
+uint64_t HashValue(const T& value, uint64_t hash) {
+  return HashBytes(&value, sizeof(value), hash);
+}
+
+uint64_t HashString(const std::string& str, uint64_t hash) {
+  hash = HashValue(uint64_t(str.size()), hash);
+  return HashBytes(str.data(), str.size(), hash);
+}
+
+uint64_t HashTypes(const std::vector<Type>& types, uint64_t hash) {
+  hash = HashValue(uint64_t(types.size()), hash);
+  return HashBytes(types.data(), types.size() * sizeof(Type), hash);
+}
+
+/* Hashes the registered modules in name order, so that the result doesn't
+ * depend on the order of the binding table. */
+uint64_t HashRegisteredModules(Environment* env) {
+  std::vector<const BindingHash::value_type*> bindings;
+  for (const BindingHash::value_type& binding :
+       env->registered_module_bindings()) {
+    bindings.push_back(&binding);
+  }
+  std::sort(bindings.begin(), bindings.end(),
+            [](const BindingHash::value_type* a,
+               const BindingHash::value_type* b) {
+              return a->first != b->first ? a->first < b->first
+                                          : a->second.index < b->second.index;
+            });
+
+  uint64_t hash = kHashSeed;
+  for (const BindingHash::value_type* binding : bindings) {
+    Module* module = env->GetModule(binding->second.index);
+    hash = HashString(binding->first, hash);
+    hash = HashValue(binding->second.index, hash);
+    hash = HashValue(module->is_host, hash);
+    hash = HashValue(uint64_t(module->exports.size()), hash);
+    for (const Export& export_ : module->exports) {
+      hash = HashString(export_.name, hash);
+      hash = HashValue(export_.kind, hash);
+      hash = HashValue(export_.index, hash);
+      if (export_.kind == ExternalKind::Func) {
+        FuncSignature* sig =
+            env->GetFuncSignature(env->GetFunc(export_.index)->sig_index);
+        hash = HashTypes(sig->param_types, hash);
+        hash = HashTypes(sig->result_types, hash);
+      } else if (export_.kind == ExternalKind::Global) {
+        Global* global = env->GetGlobal(export_.index);
+        hash = HashValue(global->typed_value.type, hash);
+        hash = HashValue(global->mutable_, hash);
+      }
+    }
+  }
+  return hash;
+}
+
+uint32_t GetFeatureBits(const Features& features) {
+  uint32_t bits = 0;
+  uint32_t bit = 1;
+#define WABT_FEATURE(variable, flag, help) \
+  if (features.variable##_enabled())       \
+    bits |= bit;                           \
+  bit <<= 1;
+#include "src/feature.def"
+#undef WABT_FEATURE
+  return bits;
+}
+
+}  // end anonymous namespace
+
+bool KeysEqual(const CodeCacheKey& a, const CodeCacheKey& b) {
+  return memcmp(&a, &b, sizeof(CodeCacheKey)) == 0;
+}
+
+wabt::Result WriteFileAtomically(const std::string& path,
+                                 const std::function<bool(FILE*)>& write) {
+  /* The temporary file's name is unique, so that processes writing the same
+   * file at once don't write to the same temporary file. */
+  std::string temp_path = path + ".XXXXXX";
+#if HAVE_UNISTD_H
+  int fd = mkstemp(&temp_path[0]);
+  if (fd < 0)
+    return wabt::Result::Error;
+  FILE* file = fdopen(fd, "wb");
+  if (!file) {
+    close(fd);
+    remove(temp_path.c_str());
+    return wabt::Result::Error;
+  }
+#else
+  temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (!file)
+    return wabt::Result::Error;
+#endif
+
+  bool ok = write(file);
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    return wabt::Result::Error;
+  }
+  return wabt::Result::Ok;
+}
+
+CodeCacheKey MakeCodeCacheKey(const void* data,
+                              size_t size,
+                              const Features& features,
+                              Environment* env,
+                              const Environment::MarkPoint& mark) {
+  CodeCacheKey key;
+  memset(&key, 0, sizeof(key));
+  key.content_hash = HashBytes(data, size, kHashSeed);
+  key.content_size = size;
+  key.imports_hash = HashRegisteredModules(env);
+  key.features = GetFeatureBits(features);
+  key.num_opcodes = static_cast<uint32_t>(Opcode::Invalid);
+  key.istream_size = mark.istream_size;
+  key.sigs_size = mark.sigs_size;
+  key.funcs_size = mark.funcs_size;
+  key.memories_size = mark.memories_size;
+  key.tables_size = mark.tables_size;
+  key.globals_size = mark.globals_size;
+  key.data_segments_size = mark.data_segments_size;
+  return key;
+}
+
+CodeCacheEntry::CodeCacheEntry(std::unique_ptr<MappedFile> file)
+    : file_(std::move(file)) {}
+
+CodeCache::CodeCache(const std::string& dir) : dir_(dir) {}
+
+std::string CodeCache::GetPath(const CodeCacheKey& key) const {
+  char name[32];
+  wabt_snprintf(name, sizeof(name), "%016" PRIx64 ".wscc",
+                HashBytes(&key, sizeof(key), kHashSeed));
+  return dir_ + "/" + name;
+}
+
+std::unique_ptr<CodeCacheEntry> CodeCache::Lookup(const CodeCacheKey& key) {
+  std::unique_ptr<MappedFile> file;
+  if (Failed(MappedFile::Open(GetPath(key).c_str(), &file)))
+    return nullptr;
+
+  const uint8_t* data = file->data();
+  size_t size = file->size();
+  if (size < sizeof(CodeCacheHeader))
+    return nullptr;
+
+  CodeCacheHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kCodeCacheMagic, sizeof(kCodeCacheMagic)) != 0 ||
+      header.version != kCodeCacheVersion || !KeysEqual(header.key, key)) {
+    return nullptr;
+  }
+
+  uint64_t funcs_size = uint64_t(header.num_funcs) * sizeof(CodeCacheFunc);
+  uint64_t types_size = uint64_t(header.num_types) * sizeof(Type);
+  if (sizeof(header) + funcs_size + types_size + header.istream_size != size)
+    return nullptr;
+
+  auto entry = MakeUnique<CodeCacheEntry>(std::move(file));
+  entry->num_funcs_ = header.num_funcs;
+  entry->funcs_ = reinterpret_cast<const CodeCacheFunc*>(data + sizeof(header));
+  entry->types_ = reinterpret_cast<const Type*>(data + sizeof(header) +
+                                                funcs_size);
+  entry->istream_data_ = data + sizeof(header) + funcs_size + types_size;
+  entry->istream_size_ = header.istream_size;
+
+  for (Index i = 0; i < entry->num_funcs_; ++i) {
+    const CodeCacheFunc& func = entry->funcs_[i];
+    if (func.offset >= entry->istream_size_ ||
+        uint64_t(func.types_start) + func.types_count > header.num_types) {
+      return nullptr;
+    }
+  }
+  return entry;
+}
+
+wabt::Result CodeCache::Store(const CodeCacheKey& key,
+                              const std::vector<CodeCacheFunc>& funcs,
+                              const std::vector<Type>& types,
+                              const uint8_t* istream_data,
+                              size_t istream_size) {
+  CodeCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCodeCacheMagic, sizeof(kCodeCacheMagic));
+  header.version = kCodeCacheVersion;
+  header.key = key;
+  header.num_funcs = funcs.size();
+  header.num_types = types.size();
+  header.istream_size = istream_size;
+
+  return WriteFileAtomically(GetPath(key), [&](FILE* file) {
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !funcs.empty())
+      ok = fwrite(funcs.data(), sizeof(CodeCacheFunc), funcs.size(), file) ==
+           funcs.size();
+    if (ok && !types.empty())
+      ok = fwrite(types.data(), sizeof(Type), types.size(), file) ==
+           types.size();
+    if (ok && istream_size != 0)
+      ok = fwrite(istream_data, istream_size, 1, file) == 1;
+    return ok;
+  });
+}
+
+}  // namespace interp
+}  // namespace wabt
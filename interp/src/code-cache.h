@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_CODE_CACHE_H_
+#define WABT_CODE_CACHE_H_
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common.h"
+#include "src/interp.h"
+#include "src/mapped-file.h"
+
+namespace wabt {
+
+class Features;
+
+namespace interp {
+
+// Bump when the istream encoding or the cache file layout changes.
+static const uint32_t kCodeCacheVersion = 3;
+
+// Identifies a compiled module. The istream refers to environment indices and
+// offsets directly, so the environment state the module was read into is part
+// of the key as well as the module contents. That includes the modules its
+// imports can resolve to: their names and exports, with the signatures of
+// exported functions and the types of exported globals.
+struct CodeCacheKey {
+  uint64_t content_hash;
+  uint64_t content_size;
+  uint64_t imports_hash;
+  uint32_t features;
+  uint32_t num_opcodes;
+  uint32_t istream_size;
+  uint32_t sigs_size;
+  uint32_t funcs_size;
+  uint32_t memories_size;
+  uint32_t tables_size;
+  uint32_t globals_size;
+  uint32_t data_segments_size;
+};
+
+bool KeysEqual(const CodeCacheKey& a, const CodeCacheKey& b);
+
+// |mark| is the state of |env| before the module was read into it.
+CodeCacheKey MakeCodeCacheKey(const void* data,
+                              size_t size,
+                              const Features&,
+                              Environment* env,
+                              const Environment::MarkPoint& mark);
+
+// Writes |path| through a uniquely named temporary file in the same
+// directory, which |write| fills and which then replaces |path|, so that
+// readers never see a partial file. Returns Error, leaving |path| alone, if
+// |write| returns false or the file can't be written.
+wabt::Result WriteFileAtomically(const std::string& path,
+                                 const std::function<bool(FILE*)>& write);
+
+// Per-function data needed to run a defined function without compiling it.
+struct CodeCacheFunc {
+  IstreamOffset offset;  // Relative to the start of the cached istream.
+  uint32_t local_decl_count;
+  uint32_t local_count;
+  uint32_t types_start;  // Index into the param_and_local_types array.
+  uint32_t types_count;
+};
+
+// A cache file mapped into memory.
+class CodeCacheEntry {
+ public:
+  explicit CodeCacheEntry(std::unique_ptr<MappedFile> file);
+
+  Index num_funcs() const { return num_funcs_; }
+  const CodeCacheFunc& func(Index index) const { return funcs_[index]; }
+  const Type* types(const CodeCacheFunc& func) const {
+    return &types_[func.types_start];
+  }
+  const uint8_t* istream_data() const { return istream_data_; }
+  size_t istream_size() const { return istream_size_; }
+
+ private:
+  friend class CodeCache;
+
+  std::unique_ptr<MappedFile> file_;
+  Index num_funcs_ = 0;
+  const CodeCacheFunc* funcs_ = nullptr;
+  const Type* types_ = nullptr;
+  const uint8_t* istream_data_ = nullptr;
+  size_t istream_size_ = 0;
+};
+
+// Stores compiled modules as files in a directory, one per key.
+class CodeCache {
+ public:
+  explicit CodeCache(const std::string& dir);
+
+  // Returns nullptr if there is no valid entry for |key|.
+  std::unique_ptr<CodeCacheEntry> Lookup(const CodeCacheKey& key);
+
+  wabt::Result Store(const CodeCacheKey& key,
+                     const std::vector<CodeCacheFunc>& funcs,
+                     const std::vector<Type>& types,
+                     const uint8_t* istream_data,
+                     size_t istream_size);
+
+ private:
+  std::string GetPath(const CodeCacheKey& key) const;
+
+  std::string dir_;
+};
+
+}  // namespace interp
+}  // namespace wabt
+
+#endif  // WABT_CODE_CACHE_H_
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/host-view.h"
+
+namespace wabt {
+namespace interp {
+
+Result HostMemoryView::GetBytes(uint64_t address,
+                                uint64_t size,
+                                char** out) const {
+  if (address + size > this->size())
+    return Result::TrapMemoryAccessOutOfBounds;
+  // The host may hand the bytes to a system call.
+  memory_->data.FillLazyRange(address, size);
+  *out = memory_->data.data() + address;
+  return Result::Ok;
+}
+
+Result HostMemoryView::GetString(uint32_t address, string_view* out) const {
+  size_t size = this->size();
+  if (address >= size)
+    return Result::TrapMemoryAccessOutOfBounds;
+  const char* begin = memory_->data.data() + address;
+  const void* end = memchr(begin, 0, size - address);
+  if (!end)
+    return Result::TrapMemoryAccessOutOfBounds;
+  *out = string_view(begin, static_cast<const char*>(end) - begin);
+  return Result::Ok;
+}
+
+Result HostMemoryView::GetLengthPrefixed(uint32_t address,
+                                         string_view* out) const {
+  MemorySpan<uint8_t> prefix;
+  Result result = GetSpan(address, sizeof(uint32_t), &prefix);
+  if (result != Result::Ok)
+    return result;
+  uint32_t length = 0;
+  for (size_t i = 0; i < prefix.size(); ++i)
+    length |= static_cast<uint32_t>(prefix.Get(i)) << (i * 8);
+  char* bytes;
+  result = GetBytes(static_cast<uint64_t>(address) + sizeof(uint32_t), length,
+                    &bytes);
+  if (result != Result::Ok)
+    return result;
+  *out = string_view(bytes, length);
+  return Result::Ok;
+}
+
+}  // namespace interp
+}  // namespace wabt
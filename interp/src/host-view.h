@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_HOST_VIEW_H_
+#define WABT_HOST_VIEW_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <cassert>
+#include <type_traits>
+
+#include "src/interp.h"
+#include "src/string-view.h"
+
+namespace wabt {
+namespace interp {
+
+// |count| consecutive values of type T in a guest's linear memory. The range
+// is checked once when the span is made, so accessing its elements needs no
+// further checks. Guest addresses needn't be aligned for T, so elements are
+// read and written with memcpy; data() is only available when they are.
+//
+// Like every view into linear memory, a span is invalidated when the memory
+// grows or is reset, which can happen whenever the guest runs, so a host
+// function shouldn't keep one after calling back into the guest.
+template <typename T>
+class MemorySpan {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "MemorySpan elements must be trivially copyable");
+
+ public:
+  MemorySpan() = default;
+  MemorySpan(char* bytes, size_t size) : bytes_(bytes), size_(size) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t size_bytes() const { return size_ * sizeof(T); }
+  char* bytes() const { return bytes_; }
+
+  // Returns null if the elements aren't aligned for T.
+  T* data() const {
+    return reinterpret_cast<uintptr_t>(bytes_) % alignof(T) == 0
+               ? reinterpret_cast<T*>(bytes_)
+               : nullptr;
+  }
+
+  T Get(size_t index) const {
+    assert(index < size_);
+    T value;
+    memcpy(&value, bytes_ + index * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  void Set(size_t index, const T& value) const {
+    assert(index < size_);
+    memcpy(bytes_ + index * sizeof(T), &value, sizeof(T));
+  }
+
+ private:
+  char* bytes_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Typed access to a guest's linear memory for host functions. Every getter
+// checks its whole range against the current memory size once and returns
+// TrapMemoryAccessOutOfBounds if it doesn't fit, leaving |out| alone; nothing
+// is copied out of the memory.
+class HostMemoryView {
+ public:
+  // |memory| may be null, e.g. for a module without a memory, in which case
+  // every access is out of bounds.
+  explicit HostMemoryView(Memory* memory) : memory_(memory) {}
+
+  Memory* memory() const { return memory_; }
+  size_t size() const { return memory_ ? memory_->data.size() : 0; }
+
+  template <typename T>
+  Result GetSpan(uint32_t address, uint32_t count, MemorySpan<T>* out) const {
+    char* bytes;
+    Result result =
+        GetBytes(address, static_cast<uint64_t>(count) * sizeof(T), &bytes);
+    if (result == Result::Ok)
+      *out = MemorySpan<T>(bytes, count);
+    return result;
+  }
+
+  // A single value at |address|, by copy.
+  template <typename T>
+  Result Load(uint32_t address, T* out) const {
+    MemorySpan<T> span;
+    Result result = GetSpan(address, 1, &span);
+    if (result == Result::Ok)
+      *out = span.Get(0);
+    return result;
+  }
+
+  // A NUL-terminated string starting at |address|, without its terminator.
+  // The terminator must be within the memory.
+  Result GetString(uint32_t address, string_view* out) const;
+
+  // A buffer starting with its size as a little-endian u32, followed by that
+  // many bytes; |out| doesn't include the size.
+  Result GetLengthPrefixed(uint32_t address, string_view* out) const;
+
+ private:
+  Result GetBytes(uint64_t address, uint64_t size, char** out) const;
+
+  Memory* memory_;
+};
+
+}  // namespace interp
+}  // namespace wabt
+
+#endif  // WABT_HOST_VIEW_H_
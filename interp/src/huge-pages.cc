@@ -0,0 +1,136 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/huge-pages.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "src/common.h"
+
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+namespace wabt {
+
+namespace {
+
+#if HAVE_MMAP && defined(MADV_HUGEPAGE)
+uintptr_t AlignUp(uintptr_t value, uintptr_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+#endif
+
+}  // end anonymous namespace
+
+bool HugePagesAvailable() {
+#if HAVE_MMAP && defined(MADV_HUGEPAGE)
+  static const bool available = []() {
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file)
+      return false;
+    char buffer[128] = {};
+    bool read = fgets(buffer, sizeof(buffer), file) != nullptr;
+    fclose(file);
+    // The current mode is bracketed, e.g. "always [madvise] never".
+    return read && !strstr(buffer, "[never]");
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+char* MapHugePageRegion(size_t size) {
+#if HAVE_MMAP && defined(MADV_HUGEPAGE)
+  if (size == 0 || !HugePagesAvailable())
+    return nullptr;
+
+  // Over-allocate, then trim to an aligned region.
+  size_t mapped_size = size + kHugePageSize;
+  void* addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED)
+    return nullptr;
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+  uintptr_t aligned_start = AlignUp(start, kHugePageSize);
+  uintptr_t aligned_end = aligned_start + size;
+  uintptr_t end = start + mapped_size;
+  if (aligned_start != start)
+    munmap(addr, aligned_start - start);
+  if (end > aligned_end)
+    munmap(reinterpret_cast<void*>(aligned_end), end - aligned_end);
+
+  char* data = reinterpret_cast<char*>(aligned_start);
+  madvise(data, size, MADV_HUGEPAGE);
+  return data;
+#else
+  return nullptr;
+#endif
+}
+
+size_t AdviseHugePages(void* data, size_t size) {
+#if HAVE_MMAP && defined(MADV_HUGEPAGE)
+  if (!HugePagesAvailable())
+    return 0;
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t aligned_start = AlignUp(start, kHugePageSize);
+  uintptr_t aligned_end = (start + size) & ~(kHugePageSize - 1);
+  if (aligned_end <= aligned_start)
+    return 0;
+  if (madvise(reinterpret_cast<void*>(aligned_start),
+              aligned_end - aligned_start, MADV_HUGEPAGE) != 0) {
+    return 0;
+  }
+  return aligned_end - aligned_start;
+#else
+  return 0;
+#endif
+}
+
+size_t GetHugePageBytes(const void* data, size_t size) {
+  FILE* file = fopen("/proc/self/smaps", "r");
+  if (!file)
+    return 0;
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t end = start + size;
+  bool overlaps = false;
+  size_t total_kb = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    uintptr_t map_start;
+    uintptr_t map_end;
+    size_t kb;
+    // Each mapping starts with its address range, e.g. "7f00-7f10 rw-p ...".
+    if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &map_start, &map_end) ==
+        2) {
+      overlaps = map_start < end && start < map_end;
+    } else if (overlaps &&
+               sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+      total_kb += kb;
+    }
+  }
+  fclose(file);
+  return total_kb * 1024;
+}
+
+}  // namespace wabt
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_HUGE_PAGES_H_
+#define WABT_HUGE_PAGES_H_
+
+#include <cstddef>
+
+namespace wabt {
+
+// The size of a transparent huge page on x86-64 and most arm64 kernels.
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Whether the kernel backs regions advised with MADV_HUGEPAGE with
+// transparent huge pages, i.e. THP is enabled in "always" or "madvise" mode.
+bool HugePagesAvailable();
+
+// Maps |size| bytes of zeroed memory at a kHugePageSize-aligned address and
+// advises huge pages for it; release it with munmap(data, size). Returns null
+// if the region can't be mapped, or if huge pages aren't available at all,
+// so that the caller can fall back to its usual allocation.
+char* MapHugePageRegion(size_t size);
+
+// Advises huge pages for the kHugePageSize-aligned part of an existing
+// region. Returns the number of bytes advised, which is 0 if the region
+// contains no aligned huge page or huge pages aren't available.
+size_t AdviseHugePages(void* data, size_t size);
+
+// Returns the number of bytes backed by huge pages in the mappings that
+// overlap the given region, according to /proc/self/smaps; 0 where that
+// isn't available.
+size_t GetHugePageBytes(const void* data, size_t size);
+
+}  // namespace wabt
+
+#endif  // WABT_HUGE_PAGES_H_
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "src/cast.h"
+#include "src/huge-pages.h"
 #include "src/stream.h"
 
 namespace wabt {
@@ -124,8 +125,16 @@ void WriteCall(Stream* stream,
 
 Environment::Environment() : istream_(new OutputBuffer()) {}
 
+void Environment::SetIstream(std::unique_ptr<OutputBuffer> istream) {
+  istream_ = std::move(istream);
+  // The istream is a plain vector, so only its aligned interior can use huge
+  // pages. Advising it again after it grows covers the new blocks.
+  if (use_huge_pages_ && !istream_->data.empty())
+    AdviseHugePages(istream_->data.data(), istream_->data.size());
+}
+
 Index Environment::FindModuleIndex(string_view name) const {
-  auto iter = module_bindings_.find(name.to_string());
+  auto iter = module_bindings_.find(name);
   if (iter == module_bindings_.end())
     return kInvalidIndex;
   return iter->second.index;
@@ -137,7 +146,7 @@ Module* Environment::FindModule(string_view name) {
 }
 
 Module* Environment::FindRegisteredModule(string_view name) {
-  auto iter = registered_module_bindings_.find(name.to_string());
+  auto iter = registered_module_bindings_.find(name);
   if (iter == registered_module_bindings_.end())
     return nullptr;
   return modules_[iter->second.index].get();
@@ -186,14 +195,114 @@ DefinedModule::DefinedModule()
 
 HostModule::HostModule(string_view name) : Module(name, true) {}
 
+CompiledModule::CompiledModule(Environment* env,
+                               DefinedModule* module,
+                               bool use_memory_template,
+                               MemoryPool* memory_pool)
+    : env_(env),
+      module_(module),
+      use_memory_template_(use_memory_template),
+      memory_pool_(memory_pool),
+      table_(Limits()) {
+  if (module->defined_memory_index != kInvalidIndex)
+    SetInitialMemory(*env->GetMemory(module->defined_memory_index));
+  if (module->defined_table_index != kInvalidIndex)
+    table_ = *env->GetTable(module->defined_table_index);
+  globals_.reserve(module->defined_global_count);
+  for (Index i = 0; i < module->defined_global_count; ++i)
+    globals_.push_back(*env->GetGlobal(module->defined_global_start + i));
+}
+
+void CompiledModule::SetInitialState(const Instance& instance) {
+  assert(instance.compiled_module_ == this);
+  if (instance.memory_index_ != kInvalidIndex)
+    SetInitialMemory(instance.memory_);
+  table_ = instance.table_;
+  globals_ = instance.globals_;
+  initialized_ = true;
+}
+
+void CompiledModule::SetInitialMemory(const Memory& memory) {
+  memory_image_.reset();
+  if (use_memory_template_) {
+    uint64_t max_pages = memory.page_limits.has_max ? memory.page_limits.max
+                                                    : WABT_MAX_PAGES;
+    // Without an image the memory is simply copied; no need to report it.
+    memory.data.FillLazyRange(0, memory.data.size());
+    MemoryImage::Create(memory.data.data(), memory.data.size(),
+                        max_pages * WABT_PAGE_SIZE, &memory_image_);
+  }
+  if (memory_image_) {
+    memory_.page_limits = memory.page_limits;
+    memory_.data = MemoryBuffer();
+  } else {
+    memory_ = memory;
+  }
+}
+
+Instance::Instance(const CompiledModule* compiled_module)
+    : compiled_module_(compiled_module),
+      memory_index_(compiled_module->shares_memory_
+                        ? kInvalidIndex
+                        : compiled_module->module_->defined_memory_index),
+      table_index_(compiled_module->module_->defined_table_index),
+      global_start_(compiled_module->module_->defined_global_start),
+      table_(compiled_module->table_),
+      globals_(compiled_module->globals_) {
+  const Memory& memory = compiled_module->memory_;
+  MemoryPool* pool = compiled_module->memory_pool_;
+  if (memory_index_ == kInvalidIndex)
+    return;
+  memory_.page_limits = memory.page_limits;
+  if (compiled_module->memory_image_)
+    memory_.data = MemoryBuffer(*compiled_module->memory_image_);
+  else
+    memory_.data = MemoryBuffer(memory.data, pool);
+}
+
+void Instance::Reset() {
+  const CompiledModule* module = compiled_module_;
+  if (memory_index_ != kInvalidIndex) {
+    memory_.page_limits = module->memory_.page_limits;
+    if (module->memory_image_)
+      memory_.data.Reset(*module->memory_image_);
+    else
+      memory_.data = module->memory_.data;
+  }
+  table_.func_indexes = module->table_.func_indexes;
+  globals_ = module->globals_;
+}
+
+Memory* Instance::GetMemory(Index env_index) {
+  return env_index == memory_index_
+             ? &memory_
+             : compiled_module_->env()->GetMemory(env_index);
+}
+
+Table* Instance::GetTable(Index env_index) {
+  return env_index == table_index_
+             ? &table_
+             : compiled_module_->env()->GetTable(env_index);
+}
+
+Global* Instance::GetGlobal(Index env_index) {
+  Index index = env_index - global_start_;
+  return index < globals_.size()
+             ? &globals_[index]
+             : compiled_module_->env()->GetGlobal(env_index);
+}
+
 Environment::MarkPoint Environment::Mark() {
   MarkPoint mark;
   mark.modules_size = modules_.size();
   mark.sigs_size = sigs_.size();
   mark.funcs_size = funcs_.size();
+  mark.defined_funcs_size = defined_funcs_.size();
+  mark.host_funcs_size = host_funcs_.size();
   mark.memories_size = memories_.size();
   mark.tables_size = tables_.size();
   mark.globals_size = globals_.size();
+  mark.data_segments_size = data_segments_.size();
   mark.istream_size = istream_->data.size();
   return mark;
 }
@@ -201,7 +310,7 @@ Environment::MarkPoint Environment::Mark() {
 void Environment::ResetToMarkPoint(const MarkPoint& mark) {
   // Destroy entries in the binding hash.
   for (size_t i = mark.modules_size; i < modules_.size(); ++i) {
-    std::string name = modules_[i]->name;
+    const std::string& name = modules_[i]->name;
     if (!name.empty())
       module_bindings_.erase(name);
   }
@@ -217,11 +326,24 @@ void Environment::ResetToMarkPoint(const MarkPoint& mark) {
   }
 
   modules_.erase(modules_.begin() + mark.modules_size, modules_.end());
+  auto sig_iter = sig_id_map_.begin();
+  while (sig_iter != sig_id_map_.end()) {
+    if (sig_iter->second >= mark.sigs_size)
+      sig_iter = sig_id_map_.erase(sig_iter);
+    else
+      ++sig_iter;
+  }
+
   sigs_.erase(sigs_.begin() + mark.sigs_size, sigs_.end());
+  sig_ids_.erase(sig_ids_.begin() + mark.sigs_size, sig_ids_.end());
   funcs_.erase(funcs_.begin() + mark.funcs_size, funcs_.end());
+  defined_funcs_.truncate(mark.defined_funcs_size);
+  host_funcs_.truncate(mark.host_funcs_size);
   memories_.erase(memories_.begin() + mark.memories_size, memories_.end());
   tables_.erase(tables_.begin() + mark.tables_size, tables_.end());
   globals_.erase(globals_.begin() + mark.globals_size, globals_.end());
+  data_segments_.erase(data_segments_.begin() + mark.data_segments_size,
+                       data_segments_.end());
   istream_->data.resize(mark.istream_size);
 }
 
@@ -621,8 +743,7 @@ inline void read_table_entry_at(const uint8_t* pc,
 }
 
 Memory* Thread::ReadMemory(const uint8_t** pc) {
-  Index memory_index = ReadU32(pc);
-  return &env_->memories_[memory_index];
+  return GetMemory(ReadU32(pc));
 }
 
 template <typename MemType>
@@ -646,6 +767,44 @@ Result Thread::GetAtomicAccessAddress(const uint8_t** pc, void** out_address) {
   return Result::Ok;
 }
 
+// The bulk memory operations check their whole range once, then copy or fill
+// it natively.
+Result Thread::MemoryCopy(const uint8_t** pc) {
+  Memory* memory = ReadMemory(pc);
+  uint32_t size = Pop<uint32_t>();
+  uint64_t src = Pop<uint32_t>();
+  uint64_t dst = Pop<uint32_t>();
+  TRAP_IF(src + size > memory->data.size() || dst + size > memory->data.size(),
+          MemoryAccessOutOfBounds);
+  char* data = memory->data.data();
+  memmove(data + dst, data + src, size);
+  return Result::Ok;
+}
+
+Result Thread::MemoryFill(const uint8_t** pc) {
+  Memory* memory = ReadMemory(pc);
+  uint32_t size = Pop<uint32_t>();
+  uint8_t value = static_cast<uint8_t>(Pop<uint32_t>());
+  uint64_t dst = Pop<uint32_t>();
+  TRAP_IF(dst + size > memory->data.size(), MemoryAccessOutOfBounds);
+  memset(memory->data.data() + dst, value, size);
+  return Result::Ok;
+}
+
+Result Thread::MemoryInit(const uint8_t** pc) {
+  Memory* memory = ReadMemory(pc);
+  DataSegment* segment = &env_->data_segments_[ReadU32(pc)];
+  uint32_t size = Pop<uint32_t>();
+  uint64_t src = Pop<uint32_t>();
+  uint64_t dst = Pop<uint32_t>();
+  TRAP_IF(src + size > segment->data.size() ||
+              dst + size > memory->data.size(),
+          MemoryAccessOutOfBounds);
+  if (size > 0)
+    memcpy(memory->data.data() + dst, segment->data.data() + src, size);
+  return Result::Ok;
+}
+
 Value& Thread::Top() {
   return Pick(1);
 }
@@ -658,6 +817,40 @@ void Thread::Reset() {
   pc_ = 0;
   value_stack_top_ = 0;
   call_stack_top_ = 0;
+  value_stack_base_ = 0;
+  call_stack_base_ = 0;
+}
+
+void Thread::set_instance(Instance* instance) {
+  instance_ = instance;
+  if (instance) {
+    instance_memory_index_ = instance->memory_index_;
+    instance_table_index_ = instance->table_index_;
+    instance_global_start_ = instance->global_start_;
+    instance_global_count_ = instance->globals_.size();
+  } else {
+    instance_memory_index_ = kInvalidIndex;
+    instance_table_index_ = kInvalidIndex;
+    instance_global_start_ = 0;
+    instance_global_count_ = 0;
+  }
+}
+
+Thread::Activation Thread::BeginActivation() {
+  Activation saved = {pc_, value_stack_base_, call_stack_base_, instance_};
+  value_stack_base_ = value_stack_top_;
+  call_stack_base_ = call_stack_top_;
+  return saved;
+}
+
+void Thread::EndActivation(const Activation& saved) {
+  value_stack_top_ = value_stack_base_;
+  call_stack_top_ = call_stack_base_;
+  value_stack_base_ = saved.value_stack_base;
+  call_stack_base_ = saved.call_stack_base;
+  pc_ = saved.pc;
+  if (instance_ != saved.instance)
+    set_instance(saved.instance);
 }
 
 Result Thread::Push(Value value) {
@@ -671,8 +864,8 @@ Value Thread::Pop() {
 }
 
 Value Thread::ValueAt(Index at) const {
-  assert(at < value_stack_top_);
-  return value_stack_[at];
+  assert(at < NumValues());
+  return value_stack_[value_stack_base_ + at];
 }
 
 template <typename T>
@@ -1183,14 +1376,33 @@ ValueTypeRep<T> Xchg(ValueTypeRep<T> lhs_rep, ValueTypeRep<T> rhs_rep) {
   return rhs_rep;
 }
 
-bool Environment::FuncSignaturesAreEqual(Index sig_index_0,
-                                         Index sig_index_1) const {
-  if (sig_index_0 == sig_index_1)
-    return true;
-  const FuncSignature* sig_0 = &sigs_[sig_index_0];
-  const FuncSignature* sig_1 = &sigs_[sig_index_1];
-  return sig_0->param_types == sig_1->param_types &&
-         sig_0->result_types == sig_1->result_types;
+Index Environment::InternFuncSignature(Index sig_index) {
+  const FuncSignature* sig = &sigs_[sig_index];
+  hash_code hash = HashCombine(
+      HashRange(sig->param_types.begin(), sig->param_types.end()),
+      HashRange(sig->result_types.begin(), sig->result_types.end()));
+  auto range = sig_id_map_.equal_range(hash);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    const FuncSignature* other = &sigs_[iter->second];
+    if (other->param_types == sig->param_types &&
+        other->result_types == sig->result_types) {
+      return iter->second;
+    }
+  }
+  sig_id_map_.emplace(hash, sig_index);
+  return sig_index;
+}
+
+Result Thread::CallHostFromRun(HostFunc* func,
+                               const uint8_t** istream,
+                               const uint8_t** pc) {
+  // The host function may call back into the guest, and a nested call can
+  // compile a lazy function, which may reallocate the istream.
+  IstreamOffset offset = *pc - *istream;
+  CHECK_TRAP(CallHost(func));
+  *istream = GetIstream();
+  *pc = *istream + offset;
+  return Result::Ok;
 }
 
 Result Thread::CallHost(HostFunc* func) {
@@ -1208,9 +1420,21 @@ Result Thread::CallHost(HostFunc* func) {
     params[i - 1].type = sig->param_types[i - 1];
   }
 
+  void* user_data = func->user_data;
+  HostCallContext context;
+  if (func->pass_context) {
+    Index memory_index =
+        func->importer ? func->importer->memory_index : kInvalidIndex;
+    context.user_data = func->user_data;
+    context.thread = this;
+    context.memory =
+        memory_index != kInvalidIndex ? GetMemory(memory_index) : nullptr;
+    user_data = &context;
+  }
+
   Result call_result =
       func->callback(func, sig, num_params, params.data(), num_results,
-                     results.data(), func->user_data);
+                     results.data(), user_data);
   TRAP_IF(call_result != Result::Ok, HostTrapped);
 
   for (size_t i = 0; i < num_results; ++i) {
@@ -1266,7 +1490,7 @@ Result Thread::Run(int num_instructions) {
       }
 
       case Opcode::Return:
-        if (call_stack_top_ == 0) {
+        if (call_stack_top_ == call_stack_base_) {
           result = Result::Returned;
           goto exit_loop;
         }
@@ -1296,14 +1520,14 @@ Result Thread::Run(int num_instructions) {
       case Opcode::GetGlobal: {
         Index index = ReadU32(&pc);
         assert(index < env_->globals_.size());
-        CHECK_TRAP(Push(env_->globals_[index].typed_value.value));
+        CHECK_TRAP(Push(GetGlobal(index)->typed_value.value));
         break;
       }
 
       case Opcode::SetGlobal: {
         Index index = ReadU32(&pc);
         assert(index < env_->globals_.size());
-        env_->globals_[index].typed_value.value = Pop();
+        GetGlobal(index)->typed_value.value = Pop();
         break;
       }
 
@@ -1332,17 +1556,17 @@ Result Thread::Run(int num_instructions) {
 
       case Opcode::CallIndirect: {
         Index table_index = ReadU32(&pc);
-        Table* table = &env_->tables_[table_index];
+        Table* table = GetTable(table_index);
         Index sig_index = ReadU32(&pc);
         Index entry_index = Pop<uint32_t>();
         TRAP_IF(entry_index >= table->func_indexes.size(), UndefinedTableIndex);
         Index func_index = table->func_indexes[entry_index];
         TRAP_IF(func_index == kInvalidIndex, UninitializedTableElement);
-        Func* func = env_->funcs_[func_index].get();
+        Func* func = env_->funcs_[func_index];
         TRAP_UNLESS(env_->FuncSignaturesAreEqual(func->sig_index, sig_index),
                     IndirectCallSignatureMismatch);
         if (func->is_host) {
-          CallHost(cast<HostFunc>(func));
+          CHECK_TRAP(CallHostFromRun(cast<HostFunc>(func), &istream, &pc));
         } else {
           CHECK_TRAP(PushCall(pc));
           GOTO(cast<DefinedFunc>(func)->offset);
@@ -1352,7 +1576,19 @@ Result Thread::Run(int num_instructions) {
 
       case Opcode::InterpCallHost: {
         Index func_index = ReadU32(&pc);
-        CallHost(cast<HostFunc>(env_->funcs_[func_index].get()));
+        CHECK_TRAP(CallHostFromRun(cast<HostFunc>(env_->funcs_[func_index]),
+                                   &istream, &pc));
+        break;
+      }
+
+      case Opcode::InterpCompileFunc: {
+        Index func_index = ReadU32(&pc);
+        auto* func = cast<DefinedFunc>(env_->funcs_[func_index]);
+        TRAP_IF(Failed(func->lazy_compiler->CompileFunc(func_index)),
+                LazyCompileFailed);
+        // Compiling appends to the istream, which may have been reallocated.
+        istream = GetIstream();
+        GOTO(func->offset);
         break;
       }
 
@@ -1568,6 +1804,18 @@ Result Thread::Run(int num_instructions) {
         CHECK_TRAP(Push<uint32_t>(ReadMemory(&pc)->page_limits.initial));
         break;
 
+      case Opcode::MemoryCopy:
+        CHECK_TRAP(MemoryCopy(&pc));
+        break;
+
+      case Opcode::MemoryFill:
+        CHECK_TRAP(MemoryFill(&pc));
+        break;
+
+      case Opcode::MemoryInit:
+        CHECK_TRAP(MemoryInit(&pc));
+        break;
+
       case Opcode::GrowMemory: {
         Memory* memory = ReadMemory(&pc);
         uint32_t old_page_size = memory->page_limits.initial;
@@ -2299,6 +2547,7 @@ void Thread::Trace(Stream* stream) {
       break;
 
     case Opcode::InterpCallHost:
+    case Opcode::InterpCompileFunc:
       stream->Writef("%s $%u\n", opcode.GetName(), ReadU32At(pc));
       break;
 
@@ -2452,6 +2701,22 @@ void Thread::Trace(Stream* stream) {
       break;
     }
 
+    case Opcode::MemoryCopy:
+    case Opcode::MemoryFill: {
+      Index memory_index = ReadU32(&pc);
+      stream->Writef("%s $%" PRIindex ":%u, %u, %u\n", opcode.GetName(),
+                     memory_index, Pick(3).i32, Pick(2).i32, Pick(1).i32);
+      break;
+    }
+
+    case Opcode::MemoryInit: {
+      Index memory_index = ReadU32(&pc);
+      stream->Writef("%s $%" PRIindex ":%u, $%u:%u, %u\n", opcode.GetName(),
+                     memory_index, Pick(3).i32, ReadU32At(pc), Pick(2).i32,
+                     Pick(1).i32);
+      break;
+    }
+
     case Opcode::I32Add:
     case Opcode::I32Sub:
     case Opcode::I32Mul:
@@ -2752,6 +3017,7 @@ void Environment::Disassemble(Stream* stream,
       }
 
       case Opcode::InterpCallHost:
+      case Opcode::InterpCompileFunc:
         stream->Writef("%s $%u\n", opcode.GetName(), ReadU32(&pc));
         break;
 
@@ -3011,6 +3277,23 @@ void Environment::Disassemble(Stream* stream,
         break;
       }
 
+      case Opcode::MemoryCopy:
+      case Opcode::MemoryFill: {
+        Index memory_index = ReadU32(&pc);
+        stream->Writef("%s $%" PRIindex ":%%[-3], %%[-2], %%[-1]\n",
+                       opcode.GetName(), memory_index);
+        break;
+      }
+
+      case Opcode::MemoryInit: {
+        Index memory_index = ReadU32(&pc);
+        Index segment_index = ReadU32(&pc);
+        stream->Writef("%s $%" PRIindex ":%%[-3], $%" PRIindex
+                       ":%%[-2], %%[-1]\n",
+                       opcode.GetName(), memory_index, segment_index);
+        break;
+      }
+
       case Opcode::InterpAlloca:
         stream->Writef("%s $%u\n", opcode.GetName(), ReadU32(&pc));
         break;
@@ -3087,18 +3370,37 @@ ExecResult Executor::RunFunction(Index func_index, const TypedValues& args) {
   ExecResult exec_result;
   Func* func = env_->GetFunc(func_index);
   FuncSignature* sig = env_->GetFuncSignature(func->sig_index);
+  exec_result.values.resize(sig->result_types.size());
+  exec_result.result =
+      RunFunction(func_index, args.size(), args.data(),
+                  exec_result.values.size(), exec_result.values.data());
+  if (exec_result.result != Result::Ok)
+    exec_result.values.clear();
+  return exec_result;
+}
+
+Result Executor::RunFunction(Index func_index,
+                             Index num_args,
+                             const TypedValue* args,
+                             Index num_results,
+                             TypedValue* out_results) {
+  Func* func = env_->GetFunc(func_index);
+  FuncSignature* sig = env_->GetFuncSignature(func->sig_index);
+  if (num_results != sig->result_types.size())
+    return Result::ResultCountMismatch;
 
-  exec_result.result = PushArgs(sig, args);
-  if (exec_result.result == Result::Ok) {
-    exec_result.result = func->is_host
+  Thread::Activation activation = thread_.BeginActivation();
+  Result result = PushArgs(sig, num_args, args);
+  if (result == Result::Ok) {
+    result = func->is_host
                  ? thread_.CallHost(cast<HostFunc>(func))
                  : RunDefinedFunction(cast<DefinedFunc>(func)->offset);
-    if (exec_result.result == Result::Ok)
-      CopyResults(sig, &exec_result.values);
+    if (result == Result::Ok)
+      CopyResults(sig, out_results);
   }
 
-  thread_.Reset();
-  return exec_result;
+  thread_.EndActivation(activation);
+  return result;
 }
 
 ExecResult Executor::RunStartFunction(DefinedModule* module) {
@@ -3125,6 +3427,20 @@ ExecResult Executor::RunExport(const Export* export_, const TypedValues& args) {
   return RunFunction(export_->index, args);
 }
 
+Result Executor::RunExport(const Export* export_,
+                           Index num_args,
+                           const TypedValue* args,
+                           Index num_results,
+                           TypedValue* out_results) {
+  if (trace_stream_) {
+    trace_stream_->Writef(">>> running export \"" PRIstringview "\":\n",
+                          WABT_PRINTF_STRING_VIEW_ARG(export_->name));
+  }
+
+  assert(export_->kind == ExternalKind::Func);
+  return RunFunction(export_->index, num_args, args, num_results, out_results);
+}
+
 ExecResult Executor::RunExportByName(Module* module,
                                      string_view name,
                                      const TypedValues& args) {
@@ -3136,6 +3452,141 @@ ExecResult Executor::RunExportByName(Module* module,
   return RunExport(export_, args);
 }
 
+Result Executor::RunExportByName(Module* module,
+                                 string_view name,
+                                 Index num_args,
+                                 const TypedValue* args,
+                                 Index num_results,
+                                 TypedValue* out_results) {
+  Export* export_ = module->GetExport(name);
+  if (!export_)
+    return Result::UnknownExport;
+  if (export_->kind != ExternalKind::Func)
+    return Result::ExportKindMismatch;
+  return RunExport(export_, num_args, args, num_results, out_results);
+}
+
+Result Executor::ResolveExport(Module* module,
+                               string_view name,
+                               ExportHandle* out_handle) {
+  Export* export_ = module->GetExport(name);
+  if (!export_)
+    return Result::UnknownExport;
+  if (export_->kind != ExternalKind::Func)
+    return Result::ExportKindMismatch;
+
+  Func* func = env_->GetFunc(export_->index);
+  const FuncSignature* sig = env_->GetFuncSignature(func->sig_index);
+  out_handle->func = func;
+  out_handle->sig = sig;
+  out_handle->sig_id = env_->GetFuncSignatureId(func->sig_index);
+  out_handle->num_params = sig->param_types.size();
+  out_handle->num_results = sig->result_types.size();
+  out_handle->instance = nullptr;
+  return Result::Ok;
+}
+
+Result Executor::ResolveExport(Instance* instance,
+                               string_view name,
+                               ExportHandle* out_handle) {
+  Result result = ResolveExport(instance->module(), name, out_handle);
+  if (result == Result::Ok)
+    out_handle->instance = instance;
+  return result;
+}
+
+Result Executor::Instantiate(const CompiledModule* module,
+                             std::unique_ptr<Instance>* out_instance) {
+  std::unique_ptr<Instance> instance(new Instance(module));
+  Result result = RunStartFunction(instance.get());
+  if (result == Result::Ok)
+    *out_instance = std::move(instance);
+  return result;
+}
+
+Result Executor::ResetInstance(Instance* instance) {
+  instance->Reset();
+  return RunStartFunction(instance);
+}
+
+Result Executor::RunStartFunction(Instance* instance) {
+  if (instance->compiled_module()->is_initialized())
+    return Result::Ok;
+
+  Instance* saved_instance = thread_.instance();
+  thread_.set_instance(instance);
+  Result result = RunStartFunction(instance->module()).result;
+  thread_.set_instance(saved_instance);
+  return result;
+}
+
+Result Executor::Preinitialize(CompiledModule* module,
+                               string_view init_export,
+                               std::unique_ptr<Instance>* out_instance) {
+  std::unique_ptr<Instance> instance;
+  Result result = Instantiate(module, &instance);
+  if (result == Result::Ok && !init_export.empty()) {
+    ExportHandle handle;
+    result = ResolveExport(instance.get(), init_export, &handle);
+    if (result == Result::Ok && handle.num_params != 0)
+      result = Result::ArgumentTypeMismatch;
+    if (result == Result::Ok && handle.num_results != 0)
+      result = Result::ResultCountMismatch;
+    if (result == Result::Ok)
+      result = Call(handle, nullptr, nullptr);
+  }
+  if (result == Result::Ok) {
+    module->SetInitialState(*instance);
+    *out_instance = std::move(instance);
+  }
+  return result;
+}
+
+Result Executor::Call(const ExportHandle& handle,
+                      const Value* args,
+                      Value* results) {
+  assert(handle.is_valid());
+  Thread::Activation activation = thread_.BeginActivation();
+  if (handle.instance != thread_.instance())
+    thread_.set_instance(handle.instance);
+  Result result = Result::Ok;
+  for (Index i = 0; i < handle.num_params && result == Result::Ok; ++i)
+    result = thread_.Push(args[i]);
+
+  if (result == Result::Ok) {
+    // The offset is read at call time, since a lazily compiled function
+    // moves from its stub to its body when it is first run.
+    Func* func = handle.func;
+    result = func->is_host
+                 ? thread_.CallHost(cast<HostFunc>(func))
+                 : RunDefinedFunction(cast<DefinedFunc>(func)->offset);
+    if (result == Result::Ok) {
+      assert(handle.num_results == thread_.NumValues());
+      for (Index i = 0; i < handle.num_results; ++i)
+        results[i] = thread_.ValueAt(i);
+    }
+  }
+
+  thread_.EndActivation(activation);
+  return result;
+}
+
+Index Executor::RunExportBatch(const ExportHandle& handle,
+                               const Value* args,
+                               Value* results,
+                               Index count,
+                               Result* out_results) {
+  Index num_failed = 0;
+  for (Index i = 0; i < count; ++i) {
+    out_results[i] = Call(handle, args, results);
+    if (out_results[i] != Result::Ok)
+      ++num_failed;
+    args += handle.num_params;
+    results += handle.num_results;
+  }
+  return num_failed;
+}
+
 Result Executor::RunDefinedFunction(IstreamOffset function_offset) {
   Result result = Result::Ok;
   thread_.set_pc(function_offset);
@@ -3157,11 +3608,13 @@ Result Executor::RunDefinedFunction(IstreamOffset function_offset) {
   return Result::Ok;
 }
 
-Result Executor::PushArgs(const FuncSignature* sig, const TypedValues& args) {
-  if (sig->param_types.size() != args.size())
+Result Executor::PushArgs(const FuncSignature* sig,
+                          Index num_args,
+                          const TypedValue* args) {
+  if (sig->param_types.size() != num_args)
     return Result::ArgumentTypeMismatch;
 
-  for (size_t i = 0; i < sig->param_types.size(); ++i) {
+  for (Index i = 0; i < num_args; ++i) {
     if (sig->param_types[i] != args[i].type)
       return Result::ArgumentTypeMismatch;
 
@@ -3173,13 +3626,12 @@ Result Executor::PushArgs(const FuncSignature* sig, const TypedValues& args) {
   return Result::Ok;
 }
 
-void Executor::CopyResults(const FuncSignature* sig, TypedValues* out_results) {
+void Executor::CopyResults(const FuncSignature* sig, TypedValue* out_results) {
   size_t expected_results = sig->result_types.size();
   assert(expected_results == thread_.NumValues());
 
-  out_results->clear();
   for (size_t i = 0; i < expected_results; ++i)
-    out_results->emplace_back(sig->result_types[i], thread_.ValueAt(i));
+    out_results[i] = TypedValue(sig->result_types[i], thread_.ValueAt(i));
 }
 
 }  // namespace interp
@@ -21,10 +21,14 @@
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "src/binding-hash.h"
 #include "src/common.h"
+#include "src/hash-util.h"
+#include "src/memory-buffer.h"
+#include "src/object-arena.h"
 #include "src/opcode.h"
 #include "src/stream.h"
 
@@ -66,10 +70,19 @@ namespace interp {
   /* we attempted to call a function with the an argument list that doesn't \
    * match the function signature */                                        \
   V(ArgumentTypeMismatch, "argument type mismatch")                         \
+  /* the caller provided room for a different number of results than the    \
+   * function signature has */                                              \
+  V(ResultCountMismatch, "result count mismatch")                           \
   /* we tried to get an export by name that doesn't exist */                \
   V(UnknownExport, "unknown export")                                        \
   /* the expected export kind doesn't match. */                             \
-  V(ExportKindMismatch, "export kind mismatch")
+  V(ExportKindMismatch, "export kind mismatch")                             \
+  /* a lazily compiled function body failed validation */                   \
+  V(TrapLazyCompileFailed, "lazy function compilation failed")             \
+  /* a host memory isn't a whole number of pages */                         \
+  V(InvalidMemorySize, "memory size is not a multiple of the page size")    \
+  /* a module is registered under a name that is already in use */         \
+  V(ModuleNameInUse, "module name is already registered")
 
 enum class Result {
 #define V(Name, str) Name,
@@ -118,6 +131,23 @@ struct Memory {
       : page_limits(limits), data(limits.initial * WABT_PAGE_SIZE) {}
 
   Limits page_limits;
+  MemoryBuffer data;
+};
+
+// Environment keeps its memories in a vector; growing it must move them, or
+// mapped, pooled and borrowed buffers would be copied to the heap.
+static_assert(std::is_nothrow_move_constructible<Memory>::value,
+              "Memory must be nothrow move constructible");
+
+// The bytes memory.init copies from. Only passive segments have any; active
+// segments are applied when their module is read, after which memory.init
+// sees them as empty.
+struct DataSegment {
+  DataSegment() = default;
+  DataSegment(const void* data, size_t size)
+      : data(static_cast<const char*>(data),
+             static_cast<const char*>(data) + size) {}
+
   std::vector<char> data;
 };
 
@@ -215,7 +245,10 @@ struct ExceptImport : Import {
       : Import(ExternalKind::Except, module_name, field_name) {}
 };
 
+struct DefinedModule;
 struct Func;
+class LazyFuncCompiler;
+class Thread;
 
 typedef Result (*HostFuncCallback)(const struct HostFunc* func,
                                    const FuncSignature* sig,
@@ -248,6 +281,9 @@ struct DefinedFunc : Func {
   Index local_decl_count;
   Index local_count;
   std::vector<Type> param_and_local_types;
+  // Non-null while the body has not been compiled yet; |offset| then points
+  // at a stub that compiles the function when it is first executed.
+  LazyFuncCompiler* lazy_compiler = nullptr;
 };
 
 struct HostFunc : Func {
@@ -260,8 +296,24 @@ struct HostFunc : Func {
 
   std::string module_name;
   std::string field_name;
-  HostFuncCallback callback;
+  HostFuncCallback callback = nullptr;
+  void* user_data = nullptr;
+  // The module that imported the function; null for functions that no
+  // module imports.
+  DefinedModule* importer = nullptr;
+  // If set, the callback's user_data is a HostCallContext for the call rather
+  // than |user_data| itself.
+  bool pass_context = false;
+};
+
+// Passed to a HostFunc with pass_context set. |memory| is the memory of the
+// importing module as seen by the calling thread: the current instance's copy
+// when the thread runs one, null if the module has no memory. See
+// HostMemoryView in src/host-view.h for reading it.
+struct HostCallContext {
   void* user_data;
+  Thread* thread;
+  Memory* memory;
 };
 
 struct Export {
@@ -285,6 +337,10 @@ class HostImportDelegate {
   virtual wabt::Result ImportTable(TableImport*,
                                    Table*,
                                    const ErrorCallback&) = 0;
+  // |import|'s limits are the ones the module declares. The delegate sets
+  // the memory's limits, and either its data, e.g. with MemoryBuffer::Borrow
+  // to give the module a host-owned buffer without copying it, or nothing,
+  // in which case zeroed data is allocated for the initial size.
   virtual wabt::Result ImportMemory(MemoryImport*,
                                     Memory*,
                                     const ErrorCallback&) = 0;
@@ -293,6 +349,17 @@ class HostImportDelegate {
                                     const ErrorCallback&) = 0;
 };
 
+// Compiles function bodies that ReadBinaryInterp deferred in lazy mode (see
+// ReadBinaryOptions::defer_function_bodies).
+class LazyFuncCompiler {
+ public:
+  virtual ~LazyFuncCompiler() {}
+
+  // Appends the function's code to the environment's istream, updates its
+  // offset and patches its stub to branch to the compiled code.
+  virtual wabt::Result CompileFunc(Index func_index) = 0;
+};
+
 struct Module {
   WABT_DISALLOW_COPY_AND_ASSIGN(Module);
   explicit Module(bool is_host);
@@ -321,6 +388,14 @@ struct DefinedModule : Module {
   Index start_func_index; /* kInvalidIndex if not defined */
   IstreamOffset istream_start;
   IstreamOffset istream_end;
+  /* null unless the module was read with deferred function bodies */
+  std::unique_ptr<LazyFuncCompiler> lazy_compiler;
+  /* The memory, table and globals the module defines itself rather than
+   * imports, i.e. the state each Instance of it gets its own copy of. */
+  Index defined_memory_index = kInvalidIndex;
+  Index defined_table_index = kInvalidIndex;
+  Index defined_global_start = 0;
+  Index defined_global_count = 0;
 };
 
 struct HostModule : Module {
@@ -337,25 +412,32 @@ class Environment {
     size_t modules_size = 0;
     size_t sigs_size = 0;
     size_t funcs_size = 0;
+    size_t defined_funcs_size = 0;
+    size_t host_funcs_size = 0;
     size_t memories_size = 0;
     size_t tables_size = 0;
     size_t globals_size = 0;
+    size_t data_segments_size = 0;
     size_t istream_size = 0;
   };
 
   Environment();
 
   OutputBuffer& istream() { return *istream_; }
-  void SetIstream(std::unique_ptr<OutputBuffer> istream) {
-    istream_ = std::move(istream);
-  }
+  void SetIstream(std::unique_ptr<OutputBuffer> istream);
   std::unique_ptr<OutputBuffer> ReleaseIstream() { return std::move(istream_); }
 
+  // Keeps the memories created from now on in huge-page regions, and advises
+  // huge pages for the istream. See MemoryBuffer::UseHugePages.
+  bool use_huge_pages() const { return use_huge_pages_; }
+  void set_use_huge_pages(bool value) { use_huge_pages_ = value; }
+
   Index GetFuncSignatureCount() const { return sigs_.size(); }
   Index GetFuncCount() const { return funcs_.size(); }
   Index GetGlobalCount() const { return globals_.size(); }
   Index GetMemoryCount() const { return memories_.size(); }
   Index GetTableCount() const { return tables_.size(); }
+  Index GetDataSegmentCount() const { return data_segments_.size(); }
   Index GetModuleCount() const { return modules_.size(); }
 
   Index GetLastModuleIndex() const {
@@ -366,7 +448,7 @@ class Environment {
   FuncSignature* GetFuncSignature(Index index) { return &sigs_[index]; }
   Func* GetFunc(Index index) {
     assert(index < funcs_.size());
-    return funcs_[index].get();
+    return funcs_[index];
   }
   Global* GetGlobal(Index index) {
     assert(index < globals_.size());
@@ -380,6 +462,10 @@ class Environment {
     assert(index < tables_.size());
     return &tables_[index];
   }
+  DataSegment* GetDataSegment(Index index) {
+    assert(index < data_segments_.size());
+    return &data_segments_[index];
+  }
   Module* GetModule(Index index) {
     assert(index < modules_.size());
     return modules_[index].get();
@@ -390,17 +476,30 @@ class Environment {
   }
   Module* FindModule(string_view name);
   Module* FindRegisteredModule(string_view name);
+  const BindingHash& registered_module_bindings() const {
+    return registered_module_bindings_;
+  }
 
   template <typename... Args>
   FuncSignature* EmplaceBackFuncSignature(Args&&... args) {
     sigs_.emplace_back(std::forward<Args>(args)...);
+    sig_ids_.push_back(InternFuncSignature(sigs_.size() - 1));
     return &sigs_.back();
   }
 
   template <typename... Args>
-  Func* EmplaceBackFunc(Args&&... args) {
-    funcs_.emplace_back(std::forward<Args>(args)...);
-    return funcs_.back().get();
+  DefinedFunc* EmplaceBackDefinedFunc(Args&&... args) {
+    DefinedFunc* func =
+        defined_funcs_.emplace_back(std::forward<Args>(args)...);
+    funcs_.push_back(func);
+    return func;
+  }
+
+  template <typename... Args>
+  HostFunc* EmplaceBackHostFunc(Args&&... args) {
+    HostFunc* func = host_funcs_.emplace_back(std::forward<Args>(args)...);
+    funcs_.push_back(func);
+    return func;
   }
 
   template <typename... Args>
@@ -418,9 +517,17 @@ class Environment {
   template <typename... Args>
   Memory* EmplaceBackMemory(Args&&... args) {
     memories_.emplace_back(std::forward<Args>(args)...);
+    if (use_huge_pages_)
+      memories_.back().data.UseHugePages();
     return &memories_.back();
   }
 
+  template <typename... Args>
+  DataSegment* EmplaceBackDataSegment(Args&&... args) {
+    data_segments_.emplace_back(std::forward<Args>(args)...);
+    return &data_segments_.back();
+  }
+
   template <typename... Args>
   Module* EmplaceBackModule(Args&&... args) {
     modules_.emplace_back(std::forward<Args>(args)...);
@@ -439,7 +546,13 @@ class Environment {
 
   HostModule* AppendHostModule(string_view name);
 
-  bool FuncSignaturesAreEqual(Index sig_index_0, Index sig_index_1) const;
+  bool FuncSignaturesAreEqual(Index sig_index_0, Index sig_index_1) const {
+    return sig_ids_[sig_index_0] == sig_ids_[sig_index_1];
+  }
+  Index GetFuncSignatureId(Index sig_index) const {
+    assert(sig_index < sig_ids_.size());
+    return sig_ids_[sig_index];
+  }
 
   MarkPoint Mark();
   void ResetToMarkPoint(const MarkPoint&);
@@ -450,15 +563,128 @@ class Environment {
  private:
   friend class Thread;
 
+  Index InternFuncSignature(Index sig_index);
+
   std::vector<std::unique_ptr<Module>> modules_;
   std::vector<FuncSignature> sigs_;
-  std::vector<std::unique_ptr<Func>> funcs_;
+  // Structurally equal signatures share an id (the index of the first of
+  // them), so signature checks on call_indirect compare two integers.
+  std::vector<Index> sig_ids_;
+  std::unordered_multimap<hash_code, Index> sig_id_map_;
+  // Funcs are owned by the arenas below; |funcs_| is the dense index of all
+  // of them, in environment func index order.
+  std::vector<Func*> funcs_;
+  ObjectArena<DefinedFunc> defined_funcs_;
+  ObjectArena<HostFunc> host_funcs_;
   std::vector<Memory> memories_;
   std::vector<Table> tables_;
   std::vector<Global> globals_;
+  std::vector<DataSegment> data_segments_;
   std::unique_ptr<OutputBuffer> istream_;
   BindingHash module_bindings_;
   BindingHash registered_module_bindings_;
+  bool use_huge_pages_ = false;
+};
+
+struct CodeCacheKey;
+class Instance;
+
+// The compiled form of a DefinedModule, shareable by any number of
+// Instances. It records the state the module defines itself (its memory,
+// table and globals) as it was right after loading, i.e. with the data and
+// elem segments applied and before the start function ran. Code, functions
+// and signatures stay in the Environment and are shared; a module read with
+// deferred bodies must not be run from several threads at once, since lazy
+// compilation appends to the istream.
+//
+// With |use_memory_template|, the initial memory is kept as a MemoryImage
+// that instances map copy-on-write, so instantiating doesn't copy it and an
+// instance only pays for the pages it writes. Where images aren't supported
+// the memory is copied as usual, into a slot of |memory_pool| if given.
+class CompiledModule {
+ public:
+  CompiledModule(Environment*,
+                 DefinedModule*,
+                 bool use_memory_template = true,
+                 MemoryPool* memory_pool = nullptr);
+  WABT_DISALLOW_COPY_AND_ASSIGN(CompiledModule);
+
+  Environment* env() const { return env_; }
+  DefinedModule* module() const { return module_; }
+  bool has_memory_template() const { return memory_image_ != nullptr; }
+
+  // Whether the initial state was replaced, by SetInitialState or from a
+  // snapshot. Instances of an initialized module don't run its start
+  // function, since its effects are already part of that state.
+  bool is_initialized() const { return initialized_; }
+
+  // Makes |instance|'s current memory, table and globals the state new
+  // instances start from. Must not run concurrently with Instantiate.
+  void SetInitialState(const Instance& instance);
+
+  // If set, instances created from now on use the module's memory in the
+  // Environment instead of a copy of their own. That memory is the one other
+  // modules import from this module, so all of them then share it. Instance
+  // resets and SetInitialState leave a shared memory as it is.
+  bool shares_memory() const { return shares_memory_; }
+  void set_shares_memory(bool value) { shares_memory_ = value; }
+
+ private:
+  friend class Instance;
+  friend wabt::Result ReadSnapshot(const std::string& filename,
+                                   const CodeCacheKey& key,
+                                   CompiledModule* module);
+
+  void SetInitialMemory(const Memory& memory);
+
+  Environment* env_;
+  DefinedModule* module_;
+  bool use_memory_template_;
+  MemoryPool* memory_pool_;
+  bool initialized_ = false;
+  bool shares_memory_ = false;
+  // If there is a memory image, memory_ has its limits but no data.
+  Memory memory_;
+  std::unique_ptr<MemoryImage> memory_image_;
+  Table table_;
+  std::vector<Global> globals_;
+};
+
+// A CompiledModule's mutable state: a copy of its memory, table and globals.
+// Code run by a Thread whose current instance this is reads and writes these
+// instead of the Environment's. Imported memories, tables and globals are
+// still shared with the exporting module.
+class Instance {
+ public:
+  explicit Instance(const CompiledModule*);
+  WABT_DISALLOW_COPY_AND_ASSIGN(Instance);
+
+  const CompiledModule* compiled_module() const { return compiled_module_; }
+  DefinedModule* module() const { return compiled_module_->module(); }
+
+  // Like the Environment accessors, but returning this instance's copy for
+  // the entities it owns.
+  Memory* GetMemory(Index env_index);
+  Table* GetTable(Index env_index);
+  Global* GetGlobal(Index env_index);
+
+  // Restores the memory, table and globals the instance was created with.
+  // A memory mapped from the module's template only has the pages written
+  // since restored; otherwise it is copied. This doesn't run the start
+  // function; see Executor::ResetInstance.
+  void Reset();
+
+ private:
+  friend class CompiledModule;
+  friend class Thread;
+
+  const CompiledModule* compiled_module_;
+  Index memory_index_;
+  Index table_index_;
+  Index global_start_;
+  Memory memory_;
+  Table table_;
+  std::vector<Global> globals_;
 };
 
 class Thread {
@@ -481,8 +707,28 @@ class Thread {
   void set_pc(IstreamOffset offset) { pc_ = offset; }
   IstreamOffset pc() const { return pc_; }
 
+  // Every call made through an Executor runs in its own activation. A host
+  // function may therefore call back into the guest on the same thread: the
+  // nested call runs on top of the suspended caller's stacks, and
+  // EndActivation drops what it left there and restores the caller's pc.
+  struct Activation {
+    IstreamOffset pc;
+    uint32_t value_stack_base;
+    uint32_t call_stack_base;
+    Instance* instance;
+  };
+
+  Activation BeginActivation();
+  void EndActivation(const Activation&);
+
+  // Code runs against |instance|'s memory, table and globals where it owns
+  // them, and the Environment's otherwise; null means the Environment's.
+  Instance* instance() const { return instance_; }
+  void set_instance(Instance*);
+
   void Reset();
-  Index NumValues() const { return value_stack_top_; }
+  // The values pushed in the current activation.
+  Index NumValues() const { return value_stack_top_ - value_stack_base_; }
   Result Push(Value) WABT_WARN_UNUSED;
   Value Pop();
   Value ValueAt(Index at) const;
@@ -494,12 +740,32 @@ class Thread {
 
  private:
   const uint8_t* GetIstream() const { return env_->istream_->data.data(); }
+  Memory* GetMemory(Index index) {
+    return index == instance_memory_index_ ? &instance_->memory_
+                                           : &env_->memories_[index];
+  }
+  Table* GetTable(Index index) {
+    return index == instance_table_index_ ? &instance_->table_
+                                          : &env_->tables_[index];
+  }
+  Global* GetGlobal(Index index) {
+    Index instance_index = index - instance_global_start_;
+    return instance_index < instance_global_count_
+               ? &instance_->globals_[instance_index]
+               : &env_->globals_[index];
+  }
+  Result CallHostFromRun(HostFunc*,
+                         const uint8_t** istream,
+                         const uint8_t** pc);
 
   Memory* ReadMemory(const uint8_t** pc);
   template <typename MemType>
   Result GetAccessAddress(const uint8_t** pc, void** out_address);
   template <typename MemType>
   Result GetAtomicAccessAddress(const uint8_t** pc, void** out_address);
+  Result MemoryCopy(const uint8_t** pc);
+  Result MemoryFill(const uint8_t** pc);
+  Result MemoryInit(const uint8_t** pc);
 
   Value& Top();
   Value& Pick(Index depth);
@@ -559,7 +825,18 @@ class Thread {
   std::vector<IstreamOffset> call_stack_;
   uint32_t value_stack_top_ = 0;
   uint32_t call_stack_top_ = 0;
+  // Where the current activation's stacks start; a return with the call
+  // stack at its base ends the activation.
+  uint32_t value_stack_base_ = 0;
+  uint32_t call_stack_base_ = 0;
   IstreamOffset pc_ = 0;
+  // The current instance, and the environment indices it owns (copied here
+  // so that each access checks a single index).
+  Instance* instance_ = nullptr;
+  Index instance_memory_index_ = kInvalidIndex;
+  Index instance_table_index_ = kInvalidIndex;
+  Index instance_global_start_ = 0;
+  Index instance_global_count_ = 0;
 };
 
 struct ExecResult {
@@ -572,6 +849,24 @@ struct ExecResult {
   TypedValues values;
 };
 
+// An exported function resolved once, by Executor::ResolveExport, so that it
+// can be called repeatedly through Executor::Call without a name lookup or
+// signature check. It stays valid until the function is removed from the
+// environment by ResetToMarkPoint.
+struct ExportHandle {
+  bool is_valid() const { return func != nullptr; }
+
+  Func* func = nullptr;
+  const FuncSignature* sig = nullptr;
+  // Equal for exports whose signatures are structurally equal; see
+  // Environment::GetFuncSignatureId.
+  Index sig_id = kInvalidIndex;
+  Index num_params = 0;
+  Index num_results = 0;
+  // The instance the export runs in; null to use the Environment's state.
+  Instance* instance = nullptr;
+};
+
 class Executor {
  public:
   explicit Executor(Environment*,
@@ -585,10 +880,74 @@ class Executor {
                              string_view name,
                              const TypedValues& args);
 
+  // These overloads read the arguments from, and write the results to,
+  // caller-provided arrays (e.g. on the stack), so they never allocate.
+  // |num_results| must equal the function's result count.
+  Result RunFunction(Index func_index,
+                     Index num_args,
+                     const TypedValue* args,
+                     Index num_results,
+                     TypedValue* out_results);
+  Result RunExport(const Export*,
+                   Index num_args,
+                   const TypedValue* args,
+                   Index num_results,
+                   TypedValue* out_results);
+  Result RunExportByName(Module* module,
+                         string_view name,
+                         Index num_args,
+                         const TypedValue* args,
+                         Index num_results,
+                         TypedValue* out_results);
+
+  Result ResolveExport(Module* module,
+                       string_view name,
+                       ExportHandle* out_handle);
+  Result ResolveExport(Instance* instance,
+                       string_view name,
+                       ExportHandle* out_handle);
+
+  // The instance that RunFunction, RunExport and RunExportByName run in;
+  // Call uses the handle's instance instead.
+  Instance* instance() const { return thread_.instance(); }
+  void set_instance(Instance* instance) { thread_.set_instance(instance); }
+
+  // Creates an instance of |module| and, unless the module is initialized,
+  // runs its start function in it.
+  Result Instantiate(const CompiledModule* module,
+                     std::unique_ptr<Instance>* out_instance);
+
+  // Resets |instance| and, unless its module is initialized, runs the start
+  // function in it again, leaving it as Instantiate did.
+  Result ResetInstance(Instance* instance);
+
+  // Instantiates |module|, then runs |init_export|, if not empty, which must
+  // take no arguments and return nothing. The resulting state becomes the
+  // module's initial state; see CompiledModule::SetInitialState. The
+  // instance is returned in its initialized state.
+  Result Preinitialize(CompiledModule* module,
+                       string_view init_export,
+                       std::unique_ptr<Instance>* out_instance);
+  // |args| must hold handle.num_params values of the types in handle.sig;
+  // they are not checked. |results| receives handle.num_results values.
+  Result Call(const ExportHandle& handle, const Value* args, Value* results);
+  // Calls |handle| |count| times. Call i reads handle.num_params values from
+  // args + i * num_params, writes handle.num_results values to
+  // results + i * num_results (left untouched if it traps) and stores its
+  // status in out_results[i]. Returns the number of calls that did not
+  // return Result::Ok.
+  Index RunExportBatch(const ExportHandle& handle,
+                       const Value* args,
+                       Value* results,
+                       Index count,
+                       Result* out_results);
+
  private:
   Result RunDefinedFunction(IstreamOffset function_offset);
-  Result PushArgs(const FuncSignature*, const TypedValues& args);
-  void CopyResults(const FuncSignature*, TypedValues* out_results);
+  // Runs the start function in |instance| unless its module is initialized.
+  Result RunStartFunction(Instance* instance);
+  Result PushArgs(const FuncSignature*, Index num_args, const TypedValue* args);
+  void CopyResults(const FuncSignature*, TypedValue* out_results);
 
   Environment* env_ = nullptr;
   Stream* trace_stream_ = nullptr;
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/lazy-memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+#include "src/common.h"
+
+#if HAVE_MMAP
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
+
+// A chunk is filled in a separate mapping and then moved into place with
+// mremap, so that other threads never see it partly filled.
+#if HAVE_MMAP && defined(MREMAP_FIXED)
+#define WABT_LAZY_MEMORY 1
+#else
+#define WABT_LAZY_MEMORY 0
+#endif
+
+namespace wabt {
+
+namespace {
+
+enum class ChunkState : uint8_t {
+  None,     // No segment overlaps the chunk; it is never protected.
+  Pending,  // Protected until its first access.
+  Filling,  // A thread is filling it in.
+  Filled,
+};
+
+}  // end anonymous namespace
+
+class LazyRegion {
+ public:
+  LazyRegion(char* data, size_t size, std::vector<LazySegment> segments)
+      : data(data), size(size), segments(std::move(segments)) {}
+
+  char* data;
+  size_t size;
+  std::vector<LazySegment> segments;
+  std::unique_ptr<std::atomic<ChunkState>[]> chunk_states;
+  std::atomic<size_t> pending_chunks{0};
+};
+
+namespace {
+
+#if WABT_LAZY_MEMORY
+// The fault handler can't take locks, so regions are kept in a fixed table.
+const size_t kMaxLazyRegions = 256;
+std::atomic<LazyRegion*> s_regions[kMaxLazyRegions];
+// The number of fault handlers that may be looking at a region. A region is
+// only deleted once it is out of the table and this has dropped to zero, so
+// a handler never uses a deleted region.
+std::atomic<size_t> s_active_handlers{0};
+struct sigaction s_previous_action;
+
+// Copies the bytes the segments have in [begin, begin + size) to |out|.
+void CopySegments(const LazyRegion* region,
+                  size_t begin,
+                  size_t size,
+                  char* out) {
+  size_t end = begin + size;
+  for (const LazySegment& segment : region->segments) {
+    size_t copy_begin = std::max(segment.offset, begin);
+    size_t copy_end = std::min(segment.offset + segment.size, end);
+    if (copy_begin < copy_end) {
+      memcpy(out + (copy_begin - begin),
+             segment.data + (copy_begin - segment.offset),
+             copy_end - copy_begin);
+    }
+  }
+}
+
+// Returns false if the fault wasn't caused by the chunk being lazy. This
+// runs in a signal handler; mmap, mremap and sched_yield aren't listed as
+// async-signal-safe, but on the systems with MREMAP_FIXED they are plain
+// system calls that take no user-space locks.
+bool FillChunk(LazyRegion* region, size_t chunk) {
+  std::atomic<ChunkState>& state = region->chunk_states[chunk];
+  ChunkState expected = ChunkState::Pending;
+  if (!state.compare_exchange_strong(expected, ChunkState::Filling)) {
+    if (expected == ChunkState::None)
+      return false;
+    // Another thread is filling the chunk, or just has; retry the access.
+    while (state.load(std::memory_order_acquire) == ChunkState::Filling)
+      sched_yield();
+    return true;
+  }
+
+  size_t begin = chunk * kLazyChunkSize;
+  size_t size = std::min(kLazyChunkSize, region->size - begin);
+  void* temp = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (temp != MAP_FAILED) {
+    CopySegments(region, begin, size, static_cast<char*>(temp));
+    char* dst = region->data + begin;
+    if (mremap(temp, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, dst) !=
+        MAP_FAILED) {
+      region->pending_chunks.fetch_sub(1, std::memory_order_relaxed);
+      state.store(ChunkState::Filled, std::memory_order_release);
+      return true;
+    }
+    munmap(temp, size);
+  }
+  state.store(ChunkState::Pending, std::memory_order_release);
+  return false;
+}
+
+void ForwardFault(int signum, siginfo_t* info, void* context) {
+  if (s_previous_action.sa_flags & SA_SIGINFO) {
+    s_previous_action.sa_sigaction(signum, info, context);
+  } else if (s_previous_action.sa_handler == SIG_DFL ||
+             s_previous_action.sa_handler == SIG_IGN) {
+    // Returning retries the access, which then gets the default action.
+    signal(signum, SIG_DFL);
+  } else {
+    s_previous_action.sa_handler(signum);
+  }
+}
+
+void HandleFault(int signum, siginfo_t* info, void* context) {
+  char* addr = static_cast<char*>(info->si_addr);
+  bool handled = false;
+  s_active_handlers.fetch_add(1);
+  for (std::atomic<LazyRegion*>& slot : s_regions) {
+    LazyRegion* region = slot.load();
+    if (!region)
+      continue;
+    char* data = region->data;
+    if (addr >= data && addr < data + region->size) {
+      handled = FillChunk(region, (addr - data) / kLazyChunkSize);
+      break;
+    }
+  }
+  s_active_handlers.fetch_sub(1);
+  if (!handled)
+    ForwardFault(signum, info, context);
+}
+
+bool InstallFaultHandler() {
+  static const bool installed = []() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = HandleFault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    return sigaction(SIGSEGV, &action, &s_previous_action) == 0;
+  }();
+  return installed;
+}
+
+// Protects each run of pending chunks; returns false on failure.
+bool ProtectPendingChunks(LazyRegion* region, size_t num_chunks) {
+  size_t chunk = 0;
+  while (chunk < num_chunks) {
+    if (region->chunk_states[chunk].load() != ChunkState::Pending) {
+      ++chunk;
+      continue;
+    }
+    size_t end = chunk + 1;
+    while (end < num_chunks &&
+           region->chunk_states[end].load() == ChunkState::Pending) {
+      ++end;
+    }
+    size_t begin_offset = chunk * kLazyChunkSize;
+    size_t end_offset = std::min(end * kLazyChunkSize, region->size);
+    if (mprotect(region->data + begin_offset, end_offset - begin_offset,
+                 PROT_NONE) != 0) {
+      return false;
+    }
+    chunk = end;
+  }
+  return true;
+}
+#endif  // WABT_LAZY_MEMORY
+
+}  // end anonymous namespace
+
+bool LazyMemoryAvailable() {
+  return WABT_LAZY_MEMORY;
+}
+
+LazyRegion* RegisterLazyRegion(char* data,
+                               size_t size,
+                               std::vector<LazySegment> segments) {
+#if WABT_LAZY_MEMORY
+  if (size == 0 || !InstallFaultHandler())
+    return nullptr;
+
+  std::unique_ptr<LazyRegion> region(
+      new LazyRegion(data, size, std::move(segments)));
+  size_t num_chunks = (size + kLazyChunkSize - 1) / kLazyChunkSize;
+  region->chunk_states.reset(new std::atomic<ChunkState>[num_chunks]);
+  for (size_t i = 0; i < num_chunks; ++i)
+    region->chunk_states[i].store(ChunkState::None);
+  size_t pending_chunks = 0;
+  for (const LazySegment& segment : region->segments) {
+    assert(segment.offset + segment.size <= size);
+    if (segment.size == 0)
+      continue;
+    size_t last = (segment.offset + segment.size - 1) / kLazyChunkSize;
+    for (size_t i = segment.offset / kLazyChunkSize; i <= last; ++i) {
+      if (region->chunk_states[i].load() == ChunkState::None) {
+        region->chunk_states[i].store(ChunkState::Pending);
+        ++pending_chunks;
+      }
+    }
+  }
+  if (pending_chunks == 0)
+    return nullptr;
+  region->pending_chunks.store(pending_chunks);
+
+  if (!ProtectPendingChunks(region.get(), num_chunks)) {
+    mprotect(data, size, PROT_READ | PROT_WRITE);
+    return nullptr;
+  }
+  for (std::atomic<LazyRegion*>& slot : s_regions) {
+    LazyRegion* expected = nullptr;
+    if (slot.compare_exchange_strong(expected, region.get()))
+      return region.release();
+  }
+  mprotect(data, size, PROT_READ | PROT_WRITE);
+  return nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+void UnregisterLazyRegion(LazyRegion* region) {
+#if WABT_LAZY_MEMORY
+  for (std::atomic<LazyRegion*>& slot : s_regions) {
+    LazyRegion* expected = region;
+    if (slot.compare_exchange_strong(expected, nullptr))
+      break;
+  }
+  // A handler that loaded the slot before it was cleared may still be using
+  // the region. Handlers that start now can't find it, so this doesn't wait
+  // for long.
+  while (s_active_handlers.load() != 0)
+    sched_yield();
+#endif
+  delete region;
+}
+
+void FillLazyRange(LazyRegion* region, size_t offset, size_t size) {
+#if WABT_LAZY_MEMORY
+  if (size == 0 || region->pending_chunks.load() == 0)
+    return;
+  assert(offset + size <= region->size);
+  size_t last = (offset + size - 1) / kLazyChunkSize;
+  for (size_t chunk = offset / kLazyChunkSize; chunk <= last; ++chunk) {
+    if (region->chunk_states[chunk].load() != ChunkState::None)
+      FillChunk(region, chunk);
+  }
+#endif
+}
+
+size_t GetLazyRegionPendingBytes(const LazyRegion* region) {
+  return region->pending_chunks.load(std::memory_order_relaxed) *
+         kLazyChunkSize;
+}
+
+}  // namespace wabt
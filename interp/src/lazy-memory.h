@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_LAZY_MEMORY_H_
+#define WABT_LAZY_MEMORY_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace wabt {
+
+// Bytes that a region should contain at |offset|, copied from |data| when
+// they are first accessed.
+struct LazySegment {
+  LazySegment(size_t offset, const char* data, size_t size)
+      : offset(offset), data(data), size(size) {}
+
+  size_t offset;
+  const char* data;  // Not owned.
+  size_t size;
+};
+
+// A region whose segments haven't all been copied yet. The chunks of the
+// region that segments overlap are protected until their first access by
+// any thread; a SIGSEGV handler then fills the chunk in and lets the access
+// continue. Faults outside every region go to the previous handler.
+// Only user-space accesses fault: a system call given a pointer into a
+// pending chunk, such as read() or write(), fails with EFAULT instead. Call
+// FillLazyRange on the bytes first.
+class LazyRegion;
+
+// The granularity at which a region is filled in.
+static const size_t kLazyChunkSize = 64 * 1024;
+
+// Whether regions can be filled in lazily on this system.
+bool LazyMemoryAvailable();
+
+// Fills the chunks of the zeroed anonymous mapping at |data| that |segments|
+// overlap on their first access; later segments overwrite earlier ones. The
+// segments' bytes must stay valid until the region is unregistered. Returns
+// null, leaving the mapping alone, if that isn't possible, in which case the
+// caller should copy the segments itself.
+LazyRegion* RegisterLazyRegion(char* data,
+                               size_t size,
+                               std::vector<LazySegment> segments);
+
+// Stops handling faults for the region, and deletes it once no other
+// thread's fault handler can be using it. Its remaining chunks stay
+// protected, so the mapping must be released without being accessed again.
+void UnregisterLazyRegion(LazyRegion*);
+
+// Fills in the chunks that overlap [offset, offset + size) now, so that the
+// bytes can be passed to system calls.
+void FillLazyRange(LazyRegion*, size_t offset, size_t size);
+
+// The number of bytes of the region that haven't been filled in yet.
+size_t GetLazyRegionPendingBytes(const LazyRegion*);
+
+}  // namespace wabt
+
+#endif  // WABT_LAZY_MEMORY_H_
@@ -16,13 +16,25 @@
 
 #include "src/leb128.h"
 
+#include <cstring>
 #include <type_traits>
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 #include "src/stream.h"
 
 #define MAX_U32_LEB128_BYTES 5
 #define MAX_U64_LEB128_BYTES 10
 
+/* The fast path decodes from an unaligned little-endian 8-byte load. */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define WABT_LEB128_FAST_PATH 1
+#else
+#define WABT_LEB128_FAST_PATH 0
+#endif
+
 namespace wabt {
 
 Offset U32Leb128Length(uint32_t value) {
@@ -144,9 +156,60 @@ void WriteS64Leb128(Stream* stream, uint64_t value, const char* desc) {
   (static_cast<type>((value) << SHIFT_AMOUNT(type, sign_bit)) >> \
    SHIFT_AMOUNT(type, sign_bit))
 
+#if WABT_LEB128_FAST_PATH
+
+static const size_t kLeb128WordBytes = 8;
+static const uint64_t kLeb128PayloadBits = 0x7f7f7f7f7f7f7f7fULL;
+
+static inline uint64_t LoadLeb128Word(const uint8_t* p) {
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+// Returns the length of the leb128 at the start of |word|, or 0 if it is
+// longer than 8 bytes.
+static inline size_t GetLeb128Length(uint64_t word) {
+  uint64_t stop_bits = ~word & ~kLeb128PayloadBits;
+  if (stop_bits == 0)
+    return 0;
+  return (Ctz(stop_bits) >> 3) + 1;
+}
+
+// Concatenates the 7-bit payloads of the first |length| bytes of |word|.
+static inline uint64_t GatherLeb128Bits(uint64_t word, size_t length) {
+  word &= ~0ULL >> (64 - length * 8);
+#if defined(__BMI2__)
+  return _pext_u64(word, kLeb128PayloadBits);
+#else
+  word &= kLeb128PayloadBits;
+  word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+  word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+  word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+  return word;
+#endif
+}
+
+#endif  // WABT_LEB128_FAST_PATH
+
+// If a whole word can be loaded, each reader first decodes any encoding that
+// needs no range checks without a per-byte loop. Everything else (the last
+// bytes of the data, the longest encodings, and malformed input) goes through
+// the byte-wise path, so the results for those are unchanged.
+
 size_t ReadU32Leb128(const uint8_t* p,
                      const uint8_t* end,
                      uint32_t* out_value) {
+#if WABT_LEB128_FAST_PATH
+  if (static_cast<size_t>(end - p) >= kLeb128WordBytes) {
+    uint64_t word = LoadLeb128Word(p);
+    size_t length = GetLeb128Length(word);
+    if (length != 0 && length < MAX_U32_LEB128_BYTES) {
+      *out_value = static_cast<uint32_t>(GatherLeb128Bits(word, length));
+      return length;
+    }
+  }
+#endif
   if (p < end && (p[0] & 0x80) == 0) {
     *out_value = LEB128_1(uint32_t);
     return 1;
@@ -175,6 +238,17 @@ size_t ReadU32Leb128(const uint8_t* p,
 size_t ReadS32Leb128(const uint8_t* p,
                      const uint8_t* end,
                      uint32_t* out_value) {
+#if WABT_LEB128_FAST_PATH
+  if (static_cast<size_t>(end - p) >= kLeb128WordBytes) {
+    uint64_t word = LoadLeb128Word(p);
+    size_t length = GetLeb128Length(word);
+    if (length != 0 && length < MAX_U32_LEB128_BYTES) {
+      uint32_t result = static_cast<uint32_t>(GatherLeb128Bits(word, length));
+      *out_value = SIGN_EXTEND(int32_t, result, length * 7 - 1);
+      return length;
+    }
+  }
+#endif
   if (p < end && (p[0] & 0x80) == 0) {
     uint32_t result = LEB128_1(uint32_t);
     *out_value = SIGN_EXTEND(int32_t, result, 6);
@@ -211,6 +285,17 @@ size_t ReadS32Leb128(const uint8_t* p,
 size_t ReadS64Leb128(const uint8_t* p,
                      const uint8_t* end,
                      uint64_t* out_value) {
+#if WABT_LEB128_FAST_PATH
+  if (static_cast<size_t>(end - p) >= kLeb128WordBytes) {
+    uint64_t word = LoadLeb128Word(p);
+    size_t length = GetLeb128Length(word);
+    if (length != 0) {
+      uint64_t result = GatherLeb128Bits(word, length);
+      *out_value = SIGN_EXTEND(int64_t, result, length * 7 - 1);
+      return length;
+    }
+  }
+#endif
   if (p < end && (p[0] & 0x80) == 0) {
     uint64_t result = LEB128_1(uint64_t);
     *out_value = SIGN_EXTEND(int64_t, result, 6);
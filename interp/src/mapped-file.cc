@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/mapped-file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wabt {
+
+// static
+Result MappedFile::Open(const char* filename,
+                        std::unique_ptr<MappedFile>* out) {
+  std::unique_ptr<MappedFile> file(new MappedFile());
+#if HAVE_MMAP
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return Result::Error;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return Result::Error;
+  }
+
+  file->size_ = st.st_size;
+  if (file->size_ != 0) {
+    void* addr = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      int error = errno;
+      close(fd);
+      errno = error;
+      return Result::Error;
+    }
+    file->data_ = static_cast<const uint8_t*>(addr);
+    file->mapped_ = true;
+    /* Modules are parsed front to back; ask for aggressive readahead. */
+    madvise(addr, file->size_, MADV_SEQUENTIAL);
+  }
+  /* The mapping stays valid after the descriptor is closed. */
+  close(fd);
+#else
+  FILE* infile = fopen(filename, "rb");
+  if (!infile)
+    return Result::Error;
+
+  Result result = Result::Error;
+  if (fseek(infile, 0, SEEK_END) == 0) {
+    long size = ftell(infile);
+    if (size >= 0 && fseek(infile, 0, SEEK_SET) == 0) {
+      file->buffer_.resize(size);
+      if (size == 0 || fread(file->buffer_.data(), size, 1, infile) == 1)
+        result = Result::Ok;
+    }
+  }
+  fclose(infile);
+  CHECK_RESULT(result);
+
+  file->data_ = DataOrNull(file->buffer_);
+  file->size_ = file->buffer_.size();
+#endif
+  *out = std::move(file);
+  return Result::Ok;
+}
+
+MappedFile::~MappedFile() {
+#if HAVE_MMAP
+  if (mapped_)
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
+
+Result MapFile(const char* filename, std::unique_ptr<MappedFile>* out) {
+  if (Failed(MappedFile::Open(filename, out))) {
+    fprintf(stderr, "unable to read file %s: %s\n", filename, strerror(errno));
+    return Result::Error;
+  }
+  return Result::Ok;
+}
+
+}  // namespace wabt
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_MAPPED_FILE_H_
+#define WABT_MAPPED_FILE_H_
+
+#include <memory>
+#include <vector>
+
+#include "src/common.h"
+
+namespace wabt {
+
+// A read-only view of a file's contents. The file is mapped with mmap where
+// available; otherwise its contents are read into memory.
+class MappedFile {
+ public:
+  // Does not print anything on failure; a missing file is not always an error
+  // for the caller. errno describes the failure.
+  static Result Open(const char* filename, std::unique_ptr<MappedFile>* out);
+
+  ~MappedFile();
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile() = default;
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> buffer_;
+};
+
+// Like ReadFile, but maps the file instead of copying it into a vector. The
+// mapping must outlive anything that refers to the data, e.g. a lazily
+// compiled module.
+Result MapFile(const char* filename, std::unique_ptr<MappedFile>* out);
+
+}  // namespace wabt
+
+#endif  // WABT_MAPPED_FILE_H_
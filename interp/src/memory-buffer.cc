@@ -0,0 +1,634 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/memory-buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "src/huge-pages.h"
+
+namespace wabt {
+
+namespace {
+
+#if HAVE_MEMFD_CREATE
+bool IsZero(const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (data[i])
+      return false;
+  }
+  return true;
+}
+
+Result WriteAll(int fd, const char* data, size_t size, size_t offset) {
+  while (size > 0) {
+    ssize_t bytes = pwrite(fd, data, size, offset);
+    if (bytes < 0) {
+      if (errno == EINTR)
+        continue;
+      return Result::Error;
+    }
+    data += bytes;
+    size -= bytes;
+    offset += bytes;
+  }
+  return Result::Ok;
+}
+#endif
+
+std::atomic<uint64_t> s_next_image_id(1);
+
+// A copy of a borrowed buffer would silently stop sharing the host's bytes.
+void CheckCopyable(const MemoryBuffer& buffer) {
+  if (buffer.is_borrowed())
+    WABT_FATAL("can't copy a memory borrowed from the host\n");
+}
+
+}  // end anonymous namespace
+
+MemoryImage::MemoryImage() : id_(s_next_image_id++) {}
+
+// static
+Result MemoryImage::Create(const char* data,
+                           size_t size,
+                           size_t max_size,
+                           std::unique_ptr<MemoryImage>* out) {
+  assert(size <= max_size);
+#if HAVE_MEMFD_CREATE
+  std::unique_ptr<MemoryImage> image(new MemoryImage());
+  image->fd_ = memfd_create("wasm-memory", MFD_CLOEXEC);
+  if (image->fd_ < 0)
+    return Result::Error;
+  if (ftruncate(image->fd_, max_size) < 0)
+    return Result::Error;
+
+  for (size_t offset = 0; offset < size; offset += WABT_PAGE_SIZE) {
+    size_t chunk_size = std::min<size_t>(WABT_PAGE_SIZE, size - offset);
+    if (!IsZero(data + offset, chunk_size))
+      CHECK_RESULT(WriteAll(image->fd_, data + offset, chunk_size, offset));
+  }
+
+  image->size_ = size;
+  image->max_size_ = max_size;
+  *out = std::move(image);
+  return Result::Ok;
+#else
+  errno = ENOSYS;
+  return Result::Error;
+#endif
+}
+
+// static
+Result MemoryImage::Open(const char* filename,
+                         uint64_t offset,
+                         size_t size,
+                         std::unique_ptr<MemoryImage>* out) {
+#if HAVE_MMAP
+  std::unique_ptr<MemoryImage> image(new MemoryImage());
+  image->fd_ = open(filename, O_RDONLY | O_CLOEXEC);
+  if (image->fd_ < 0)
+    return Result::Error;
+
+  image->offset_ = offset;
+  image->size_ = size;
+  image->max_size_ = size;
+  *out = std::move(image);
+  return Result::Ok;
+#else
+  errno = ENOSYS;
+  return Result::Error;
+#endif
+}
+
+MemoryImage::~MemoryImage() {
+#if HAVE_MMAP
+  if (fd_ >= 0)
+    close(fd_);
+#endif
+}
+
+MemoryPool::MemoryPool(const std::vector<size_t>& size_classes,
+                       size_t max_free_slots)
+    : size_classes_(size_classes),
+      free_slots_(size_classes.size()),
+      max_free_slots_(max_free_slots) {
+  std::sort(size_classes_.begin(), size_classes_.end());
+}
+
+MemoryPool::~MemoryPool() {
+  assert(stats_.used_slots == 0);
+  for (const std::vector<Slot>& free_slots : free_slots_) {
+    for (const Slot& slot : free_slots)
+      FreeSlot(slot);
+  }
+}
+
+void MemoryPool::Reserve(size_t size, size_t count) {
+  Index size_class = FindSizeClass(size);
+  if (size_class == kInvalidIndex)
+    return;
+
+  size_t slot_size = size_classes_[size_class];
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Slot>& free_slots = free_slots_[size_class];
+  while (count-- > 0 && free_slots.size() < max_free_slots_) {
+    char* data = AllocateSlot(slot_size);
+    if (!data)
+      break;
+    free_slots.push_back(Slot{data, slot_size, 0});
+    stats_.free_slots++;
+    stats_.resident_bytes += slot_size;
+  }
+}
+
+MemoryPool::Stats MemoryPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool MemoryPool::Acquire(size_t size, Slot* out_slot) {
+  Index size_class = FindSizeClass(size);
+  if (size_class == kInvalidIndex) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.oversized++;
+    return false;
+  }
+
+  size_t slot_size = size_classes_[size_class];
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Slot>& free_slots = free_slots_[size_class];
+    if (!free_slots.empty()) {
+      *out_slot = free_slots.back();
+      free_slots.pop_back();
+      stats_.hits++;
+      stats_.free_slots--;
+      stats_.used_slots++;
+      return true;
+    }
+  }
+
+  // Allocate outside the lock; faulting in a large slot takes a while.
+  char* data = AllocateSlot(slot_size);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.misses++;
+  if (!data)
+    return false;
+  *out_slot = Slot{data, slot_size, 0};
+  stats_.used_slots++;
+  stats_.resident_bytes += slot_size;
+  return true;
+}
+
+void MemoryPool::Release(const Slot& slot) {
+  Index size_class = FindSizeClass(slot.size);
+  assert(size_class != kInvalidIndex && size_classes_[size_class] == slot.size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.used_slots--;
+    std::vector<Slot>& free_slots = free_slots_[size_class];
+    if (free_slots.size() < max_free_slots_) {
+      free_slots.push_back(slot);
+      stats_.free_slots++;
+      return;
+    }
+    stats_.resident_bytes -= slot.size;
+  }
+  FreeSlot(slot);
+}
+
+Index MemoryPool::FindSizeClass(size_t size) const {
+  auto iter =
+      std::lower_bound(size_classes_.begin(), size_classes_.end(), size);
+  if (iter == size_classes_.end())
+    return kInvalidIndex;
+  return iter - size_classes_.begin();
+}
+
+// static
+char* MemoryPool::AllocateSlot(size_t size) {
+#if HAVE_MMAP
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+  // Fault the slot in now rather than on first use.
+  flags |= MAP_POPULATE;
+#endif
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return addr == MAP_FAILED ? nullptr : static_cast<char*>(addr);
+#else
+  char* data = static_cast<char*>(calloc(size, 1));
+  // Fault the slot in now rather than on first use.
+  if (data)
+    memset(data, 0, size);
+  return data;
+#endif
+}
+
+// static
+void MemoryPool::FreeSlot(const Slot& slot) {
+#if HAVE_MMAP
+  munmap(slot.data, slot.size);
+#else
+  free(slot.data);
+#endif
+}
+
+MemoryBuffer::MemoryBuffer(size_t size) : heap_(size) {
+  data_ = DataOrNull(heap_);
+  size_ = size;
+}
+
+MemoryBuffer::MemoryBuffer(size_t size, MemoryPool* pool) {
+  MemoryPool::Slot slot;
+  if (pool && pool->Acquire(size, &slot)) {
+    UseSlot(pool, slot, size, nullptr, 0);
+  } else {
+    heap_.resize(size);
+    data_ = DataOrNull(heap_);
+    size_ = size;
+  }
+}
+
+MemoryBuffer::MemoryBuffer(const MemoryBuffer& other, MemoryPool* pool) {
+  CheckCopyable(other);
+  MemoryPool::Slot slot;
+  if (pool && pool->Acquire(other.size_, &slot)) {
+    UseSlot(pool, slot, other.size_, other.data_, other.size_);
+  } else {
+    heap_.assign(other.data_, other.data_ + other.size_);
+    data_ = DataOrNull(heap_);
+    size_ = other.size_;
+    if (other.huge_pages_)
+      UseHugePages();
+  }
+}
+
+MemoryBuffer::MemoryBuffer(const MemoryImage& image) {
+#if HAVE_MMAP
+  if (image.size_ == 0)
+    return;
+
+  void* addr = mmap(nullptr, image.size_, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    image.fd_, image.offset_);
+  if (addr != MAP_FAILED) {
+    data_ = static_cast<char*>(addr);
+    size_ = mapped_size_ = image.size_;
+    mapped_file_size_ = image.max_size_;
+    image_id_ = image.id_;
+    return;
+  }
+
+  heap_.resize(image.size_);
+  size_t offset = 0;
+  while (offset < image.size_) {
+    ssize_t bytes = pread(image.fd_, &heap_[offset], image.size_ - offset,
+                          image.offset_ + offset);
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes <= 0)
+      break;
+    offset += bytes;
+  }
+  data_ = heap_.data();
+  size_ = image.size_;
+#endif
+}
+
+MemoryBuffer::MemoryBuffer(const MemoryBuffer& other) {
+  CheckCopyable(other);
+  if (other.huge_pages_) {
+    huge_pages_ = true;
+    if (MoveToHugePages(other.size_)) {
+      if (other.size_ != 0)
+        memcpy(data_, other.data_, other.size_);
+      return;
+    }
+  }
+  heap_.assign(other.data_, other.data_ + other.size_);
+  data_ = DataOrNull(heap_);
+  size_ = other.size_;
+}
+
+MemoryBuffer::MemoryBuffer(MemoryBuffer&& other) noexcept {
+  *this = std::move(other);
+}
+
+// static
+MemoryBuffer MemoryBuffer::Borrow(char* data, size_t size, size_t capacity) {
+  assert(size <= capacity);
+  MemoryBuffer buffer;
+  buffer.data_ = data;
+  buffer.size_ = size;
+  buffer.borrowed_ = true;
+  buffer.borrowed_capacity_ = capacity;
+  return buffer;
+}
+
+MemoryBuffer& MemoryBuffer::operator=(const MemoryBuffer& other) {
+  if (this == &other)
+    return *this;
+
+  CheckCopyable(other);
+  size_t reusable_size = is_pooled() ? pool_slot_size_ : mapped_size_;
+  if ((is_pooled() || is_huge_region()) && other.size_ <= reusable_size) {
+    if (other.size_ != 0)
+      memcpy(data_, other.data_, other.size_);
+    if (size_ > other.size_)
+      memset(data_ + other.size_, 0, size_ - other.size_);
+    size_ = other.size_;
+    return *this;
+  }
+
+  // Reuses the heap allocation, if any.
+  ReleaseStorage();
+  if (huge_pages_ && MoveToHugePages(other.size_)) {
+    if (other.size_ != 0)
+      memcpy(data_, other.data_, other.size_);
+    return *this;
+  }
+  heap_.assign(other.data_, other.data_ + other.size_);
+  data_ = DataOrNull(heap_);
+  size_ = other.size_;
+  return *this;
+}
+
+MemoryBuffer& MemoryBuffer::operator=(MemoryBuffer&& other) noexcept {
+  if (this != &other) {
+    ReleaseStorage();
+    heap_ = std::move(other.heap_);
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_size_ = other.mapped_size_;
+    mapped_file_size_ = other.mapped_file_size_;
+    image_id_ = other.image_id_;
+    pool_ = other.pool_;
+    pool_slot_size_ = other.pool_slot_size_;
+    huge_pages_ = other.huge_pages_;
+    lazy_mapping_ = other.lazy_mapping_;
+    lazy_region_ = other.lazy_region_;
+    borrowed_ = other.borrowed_;
+    borrowed_capacity_ = other.borrowed_capacity_;
+    other.heap_.clear();
+    other.data_ = nullptr;
+    other.size_ = other.mapped_size_ = other.mapped_file_size_ = 0;
+    other.image_id_ = 0;
+    other.pool_ = nullptr;
+    other.pool_slot_size_ = 0;
+    other.huge_pages_ = false;
+    other.lazy_mapping_ = false;
+    other.lazy_region_ = nullptr;
+    other.borrowed_ = false;
+    other.borrowed_capacity_ = 0;
+  }
+  return *this;
+}
+
+MemoryBuffer::~MemoryBuffer() {
+  ReleaseStorage();
+}
+
+void MemoryBuffer::resize(size_t size) {
+  if (borrowed_) {
+    if (size <= borrowed_capacity_)
+      size_ = size;
+    else
+      MoveToHeap(size);
+    return;
+  }
+
+  if (is_pooled()) {
+    if (size <= pool_slot_size_) {
+      // Keep the bytes past the end zero, as the pool expects.
+      if (size < size_)
+        memset(data_ + size, 0, size_ - size);
+      size_ = size;
+      return;
+    }
+
+    MemoryPool::Slot slot;
+    if (!pool_->Acquire(size, &slot)) {
+      if (!huge_pages_ || !MoveToHugePages(size))
+        MoveToHeap(size);
+      return;
+    }
+    MemoryBuffer old_buffer(std::move(*this));
+    UseSlot(old_buffer.pool_, slot, size, old_buffer.data_, old_buffer.size_);
+    return;
+  }
+
+  if (!is_mapped()) {
+    if (huge_pages_ && MoveToHugePages(size))
+      return;
+    heap_.resize(size);
+    data_ = DataOrNull(heap_);
+    size_ = size;
+    return;
+  }
+
+  if (size <= mapped_size_) {
+    // Keep the mapped bytes past the end zero, in case they are reused.
+    if (size < size_)
+      memset(data_ + size, 0, size_ - size);
+    size_ = size;
+    return;
+  }
+
+#if HAVE_MEMFD_CREATE
+  // A memfd image is as large as the memory can grow, and the bytes past its
+  // initial contents are holes, so the mapping can grow in place.
+  if (size <= mapped_file_size_) {
+    void* addr = mremap(data_, mapped_size_, size, MREMAP_MAYMOVE);
+    if (addr != MAP_FAILED) {
+      data_ = static_cast<char*>(addr);
+      size_ = mapped_size_ = size;
+      return;
+    }
+  }
+#endif
+  if (!huge_pages_ || !MoveToHugePages(size))
+    MoveToHeap(size);
+}
+
+void MemoryBuffer::Reset(const MemoryImage& image) {
+#if HAVE_MMAP
+  // Dropping the pages of a private file mapping reverts them to the file's
+  // contents. Pages past the image's size are holes in a memfd image, so
+  // they read as zero again, as the bytes past the end must.
+  if (image_id_ == image.id_ && is_mapped() &&
+      madvise(data_, mapped_size_, MADV_DONTNEED) == 0) {
+    size_ = image.size_;
+    return;
+  }
+#endif
+  bool huge_pages = huge_pages_;
+  *this = MemoryBuffer(image);
+  huge_pages_ = huge_pages;
+}
+
+void MemoryBuffer::UseHugePages() {
+  if (!HugePagesAvailable())
+    return;
+  huge_pages_ = true;
+  if (!is_mapped() && !is_pooled() && !borrowed_)
+    MoveToHugePages(size_);
+}
+
+size_t MemoryBuffer::GetHugePageBytes() const {
+  return is_huge_region() ? wabt::GetHugePageBytes(data_, size_) : 0;
+}
+
+void MemoryBuffer::UseLazyMapping(size_t size, size_t max_size) {
+#if HAVE_MMAP
+  if (size != 0 && !huge_pages_ && !is_pooled() && LazyMemoryAvailable()) {
+    // Reserve |max_size| if possible; the reservation costs nothing until
+    // it is touched, and unlike a mapping with lazy chunks, which is split
+    // into many areas, it doesn't need to be moved to grow.
+    void* addr = MAP_FAILED;
+    size_t mapped_size = std::max(size, max_size);
+    for (;;) {
+      addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (addr != MAP_FAILED || mapped_size == size)
+        break;
+      mapped_size = size;
+    }
+    if (addr != MAP_FAILED) {
+      ReleaseStorage();
+      std::vector<char>().swap(heap_);
+      data_ = static_cast<char*>(addr);
+      size_ = size;
+      mapped_size_ = mapped_file_size_ = mapped_size;
+      lazy_mapping_ = true;
+      return;
+    }
+  }
+#endif
+  resize(0);
+  resize(size);
+}
+
+void MemoryBuffer::SetLazySegments(const std::vector<LazySegment>& segments) {
+  if (lazy_mapping_ && !lazy_region_) {
+    lazy_region_ = RegisterLazyRegion(data_, size_, segments);
+    if (lazy_region_)
+      return;
+  }
+  for (const LazySegment& segment : segments) {
+    assert(segment.offset + segment.size <= size_);
+    memcpy(data_ + segment.offset, segment.data, segment.size);
+  }
+}
+
+size_t MemoryBuffer::GetLazyPendingBytes() const {
+  return lazy_region_ ? GetLazyRegionPendingBytes(lazy_region_) : 0;
+}
+
+void MemoryBuffer::FillLazyRange(size_t offset, size_t size) const {
+  if (lazy_region_)
+    wabt::FillLazyRange(lazy_region_, offset, size);
+}
+
+void MemoryBuffer::ReleaseStorage() {
+  if (borrowed_) {
+    data_ = nullptr;
+    size_ = 0;
+    borrowed_ = false;
+    borrowed_capacity_ = 0;
+    return;
+  }
+
+  if (is_pooled()) {
+    pool_->Release(MemoryPool::Slot{data_, pool_slot_size_, size_});
+    data_ = nullptr;
+    size_ = pool_slot_size_ = 0;
+    pool_ = nullptr;
+    return;
+  }
+
+  if (!is_mapped())
+    return;
+  if (lazy_region_) {
+    UnregisterLazyRegion(lazy_region_);
+    lazy_region_ = nullptr;
+  }
+  lazy_mapping_ = false;
+#if HAVE_MMAP
+  munmap(data_, mapped_size_);
+#endif
+  data_ = nullptr;
+  size_ = mapped_size_ = mapped_file_size_ = 0;
+  image_id_ = 0;
+}
+
+void MemoryBuffer::UseSlot(MemoryPool* pool,
+                           const MemoryPool::Slot& slot,
+                           size_t size,
+                           const char* data,
+                           size_t copy_size) {
+  assert(!is_pooled() && !is_mapped() && copy_size <= size);
+  if (copy_size != 0)
+    memcpy(slot.data, data, copy_size);
+  if (slot.dirty_size > copy_size)
+    memset(slot.data + copy_size, 0, slot.dirty_size - copy_size);
+  data_ = slot.data;
+  size_ = size;
+  pool_ = pool;
+  pool_slot_size_ = slot.size;
+}
+
+void MemoryBuffer::MoveToHeap(size_t size) {
+  std::vector<char> heap(size);
+  if (size_ != 0 && size != 0)
+    memcpy(heap.data(), data_, std::min(size, size_));
+  ReleaseStorage();
+  heap_.swap(heap);
+  data_ = DataOrNull(heap_);
+  size_ = size;
+}
+
+bool MemoryBuffer::MoveToHugePages(size_t size) {
+  if (size == 0)
+    return false;
+  // Round up, and double on growth, so that growing a page at a time
+  // doesn't copy the memory each time; the unused tail is never touched.
+  size_t capacity = std::max(size, is_huge_region() ? 2 * mapped_size_ : 0);
+  capacity = (capacity + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  char* data = MapHugePageRegion(capacity);
+  if (!data)
+    return false;
+  if (size_ != 0)
+    memcpy(data, data_, std::min(size, size_));
+  ReleaseStorage();
+  std::vector<char>().swap(heap_);
+  data_ = data;
+  size_ = size;
+  mapped_size_ = mapped_file_size_ = capacity;
+  return true;
+}
+
+}  // namespace wabt
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_MEMORY_BUFFER_H_
+#define WABT_MEMORY_BUFFER_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "src/common.h"
+#include "src/lazy-memory.h"
+
+namespace wabt {
+
+// The initial contents of a linear memory, kept in a file so that
+// MemoryBuffers can map it copy-on-write.
+class MemoryImage {
+ public:
+  // Writes |data| to an anonymous file (memfd); only available where
+  // HAVE_MEMFD_CREATE is set. |max_size| is the size the memory may grow to;
+  // the file is sized to it so that a mapping can grow in place. All-zero
+  // pages of |data| are left as holes in the file. Returns Error, and sets
+  // errno, if the image can't be created.
+  static Result Create(const char* data,
+                       size_t size,
+                       size_t max_size,
+                       std::unique_ptr<MemoryImage>* out);
+
+  // Uses |size| bytes of an existing file, starting at |offset|, which must
+  // be a multiple of the system page size. A mapping of the image can't grow
+  // past the end of those bytes, so growing a memory copies it to the heap.
+  // Only available where HAVE_MMAP is set.
+  static Result Open(const char* filename,
+                     uint64_t offset,
+                     size_t size,
+                     std::unique_ptr<MemoryImage>* out);
+
+  ~MemoryImage();
+
+  size_t size() const { return size_; }
+  size_t max_size() const { return max_size_; }
+
+ private:
+  friend class MemoryBuffer;
+
+  MemoryImage();
+
+  // Identifies the image to the buffers mapping it; unlike its address, an
+  // id is never reused.
+  uint64_t id_;
+  int fd_ = -1;
+  uint64_t offset_ = 0;
+  size_t size_ = 0;
+  size_t max_size_ = 0;
+};
+
+// Recycles pre-faulted blocks ("slots") for linear memories, so that high
+// instance churn doesn't keep allocating and freeing large blocks. A slot
+// isn't cleared when it is released; the next user clears only the bytes
+// the previous one used and doesn't overwrite itself.
+// Slots come in a fixed set of size classes; a memory larger than every
+// class is allocated as usual. Thread-safe. The pool must outlive the
+// buffers using its slots.
+class MemoryPool {
+ public:
+  struct Stats {
+    uint64_t hits = 0;       // Acquires served by a free slot.
+    uint64_t misses = 0;     // Acquires that allocated a new slot.
+    uint64_t oversized = 0;  // Requests larger than every size class.
+    size_t free_slots = 0;
+    size_t used_slots = 0;
+    // The size of all slots, free or used. Slots are faulted in when they
+    // are allocated and kept that way, so this is their resident size.
+    size_t resident_bytes = 0;
+  };
+
+  // |size_classes| are slot sizes in bytes. At most |max_free_slots| free
+  // slots are kept per class; further released slots are freed.
+  MemoryPool(const std::vector<size_t>& size_classes, size_t max_free_slots);
+  ~MemoryPool();
+  WABT_DISALLOW_COPY_AND_ASSIGN(MemoryPool);
+
+  // Allocates |count| free slots of the class that fits |size|, up to the
+  // free slot limit.
+  void Reserve(size_t size, size_t count);
+
+  Stats GetStats() const;
+
+ private:
+  friend class MemoryBuffer;
+
+  struct Slot {
+    char* data;
+    size_t size;
+    // The bytes past this are zero.
+    size_t dirty_size;
+  };
+
+  // Returns false if |size| is larger than every class.
+  bool Acquire(size_t size, Slot* out_slot);
+  void Release(const Slot& slot);
+
+  Index FindSizeClass(size_t size) const;
+  static char* AllocateSlot(size_t size);
+  static void FreeSlot(const Slot& slot);
+
+  std::vector<size_t> size_classes_;
+  std::vector<std::vector<Slot>> free_slots_;
+  size_t max_free_slots_;
+  mutable std::mutex mutex_;
+  Stats stats_;
+};
+
+// The bytes of a linear memory. Usually a zero-initialized heap allocation;
+// a buffer created from a MemoryImage instead maps the image privately, so
+// it costs only the pages that are written, and one created with a
+// MemoryPool uses a pool slot. A buffer can also be asked to keep its bytes
+// in a region backed by transparent huge pages (see UseHugePages). Copying a
+// buffer copies its bytes to the heap, or to a huge-page region if the
+// original uses one, but assigning to a buffer reuses its heap block, slot
+// or region if the bytes fit. A buffer can also be filled lazily from
+// bytes kept elsewhere, such as a mapped module file (see SetLazySegments),
+// or wrap bytes owned by the host (see Borrow).
+// Moving a buffer never copies its bytes, and can't throw, so containers of
+// buffers move rather than copy them when they grow.
+class MemoryBuffer {
+ public:
+  MemoryBuffer() = default;
+  explicit MemoryBuffer(size_t size);
+  // Uses a slot from |pool|, or the heap if |pool| is null or has no slot
+  // large enough. Growing past the slot moves to a larger one.
+  MemoryBuffer(size_t size, MemoryPool* pool);
+  // Like the above, but with a copy of |other|'s bytes.
+  MemoryBuffer(const MemoryBuffer& other, MemoryPool* pool);
+  // Falls back to a heap copy of the image if it can't be mapped.
+  explicit MemoryBuffer(const MemoryImage&);
+  MemoryBuffer(const MemoryBuffer&);
+  MemoryBuffer(MemoryBuffer&&) noexcept;
+  // Uses |size| bytes at |data| in place. They stay owned by the caller and
+  // must outlive the buffer. The buffer grows in place up to |capacity|
+  // bytes, which must be valid too and should be zero; growing past that
+  // moves the bytes to the heap, so a memory using them should have
+  // |capacity| as its maximum size. A borrowed buffer can be moved but not
+  // copied, since the copy would no longer share the caller's bytes.
+  static MemoryBuffer Borrow(char* data, size_t size, size_t capacity);
+  static MemoryBuffer Borrow(char* data, size_t size) {
+    return Borrow(data, size, size);
+  }
+  MemoryBuffer& operator=(const MemoryBuffer&);
+  MemoryBuffer& operator=(MemoryBuffer&&) noexcept;
+  ~MemoryBuffer();
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_mapped() const { return mapped_size_ != 0; }
+  bool is_pooled() const { return pool_ != nullptr; }
+  bool uses_huge_pages() const { return huge_pages_; }
+  bool is_borrowed() const { return borrowed_; }
+
+  char& operator[](size_t index) { return data_[index]; }
+  const char& operator[](size_t index) const { return data_[index]; }
+
+  // New bytes are zero. May move the data.
+  void resize(size_t size);
+
+  // Restores the contents and size of |image|. If the buffer still maps
+  // |image|, this only drops the pages written since, so its cost depends on
+  // the pages touched rather than the size of the memory.
+  void Reset(const MemoryImage& image);
+
+  // Moves a heap buffer to a kHugePageSize-aligned region advised for huge
+  // pages, and keeps the bytes in such a region when it grows past its
+  // mapping or slot. This cuts TLB misses for memories that are large and
+  // accessed randomly. Does nothing if huge pages aren't available.
+  void UseHugePages();
+
+  // The number of bytes currently backed by huge pages.
+  size_t GetHugePageBytes() const;
+
+  // Replaces the contents with |size| zero bytes in an anonymous mapping,
+  // whose pages cost nothing until they are touched, for SetLazySegments.
+  // Address space is reserved for growth up to |max_size|; growing past it
+  // copies the buffer. Where lazy filling isn't available, or the buffer
+  // uses huge pages or a pool, this just clears and resizes the buffer.
+  void UseLazyMapping(size_t size, size_t max_size);
+
+  // Copies |segments| into a buffer from UseLazyMapping on their first
+  // access rather than now; see RegisterLazyRegion. The segments' bytes must
+  // stay valid until the buffer is released, or moved by a copy, growth
+  // past its mapping or Reset, which fill in the rest first. For any other
+  // buffer, or if the region can't be registered, copies them now.
+  void SetLazySegments(const std::vector<LazySegment>& segments);
+
+  // The number of bytes that SetLazySegments hasn't copied in yet.
+  size_t GetLazyPendingBytes() const;
+
+  // Copies in the lazy segments' bytes in [offset, offset + size) now. Bytes
+  // passed to a system call must be filled in first; the kernel doesn't
+  // fault on pending chunks, so the call would fail with EFAULT. The
+  // contents don't change, so this is const.
+  void FillLazyRange(size_t offset, size_t size) const;
+
+ private:
+  // Unmaps the mapping or returns the slot, if any.
+  void ReleaseStorage();
+  // Takes |slot| for the first |size| bytes, of which the first |copy_size|
+  // are copied from |data| and the rest cleared.
+  void UseSlot(MemoryPool* pool,
+               const MemoryPool::Slot& slot,
+               size_t size,
+               const char* data,
+               size_t copy_size);
+  void MoveToHeap(size_t size);
+  // Returns false, leaving the buffer alone, if no region can be mapped.
+  bool MoveToHugePages(size_t size);
+  // Whether the data is in a region from MoveToHugePages.
+  bool is_huge_region() const {
+    return is_mapped() && image_id_ == 0 && !lazy_mapping_;
+  }
+
+  char* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<char> heap_;
+  // The length of the mapping and of the image file it maps, or 0 if the
+  // data is on the heap. A huge-page region has no file; both are its
+  // length.
+  size_t mapped_size_ = 0;
+  size_t mapped_file_size_ = 0;
+  uint64_t image_id_ = 0;
+  // The pool and size of the slot holding the data, if any.
+  MemoryPool* pool_ = nullptr;
+  size_t pool_slot_size_ = 0;
+  bool huge_pages_ = false;
+  // Whether the data is in a mapping from UseLazyMapping, and the region
+  // handling its lazy chunks, if any.
+  bool lazy_mapping_ = false;
+  LazyRegion* lazy_region_ = nullptr;
+  // Whether the data is owned by the caller of Borrow, and how far it may
+  // grow in place.
+  bool borrowed_ = false;
+  size_t borrowed_capacity_ = 0;
+};
+
+}  // namespace wabt
+
+#endif  // WABT_MEMORY_BUFFER_H_
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_OBJECT_ARENA_H_
+#define WABT_OBJECT_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/common.h"
+
+namespace wabt {
+
+// Append-only storage for objects that are created in bulk and destroyed
+// together from the back. Objects are constructed in place inside fixed-size
+// chunks, so creating one rarely allocates, neighbours in creation order are
+// neighbours in memory, and addresses are stable for the object's lifetime.
+// Truncating keeps the chunks around to be reused by later objects.
+template <class T, size_t kChunkSize = 256>
+class ObjectArena {
+ public:
+  typedef T value_type;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef size_t size_type;
+
+  ObjectArena() = default;
+  WABT_DISALLOW_COPY_AND_ASSIGN(ObjectArena);
+
+  ~ObjectArena() { truncate(0); }
+
+  reference operator[](size_type index) {
+    assert(index < size_);
+    return *slot(index);
+  }
+
+  const_reference operator[](size_type index) const {
+    assert(index < size_);
+    return *slot(index);
+  }
+
+  reference back() { return (*this)[size_ - 1]; }
+  const_reference back() const { return (*this)[size_ - 1]; }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+
+  template <typename... Args>
+  T* emplace_back(Args&&... args) {
+    if (size_ == chunks_.size() * kChunkSize)
+      chunks_.emplace_back(new Chunk);
+    T* object = new (slot(size_)) T(std::forward<Args>(args)...);
+    ++size_;
+    return object;
+  }
+
+  // Destroys the objects at |new_size| and above, newest first.
+  void truncate(size_type new_size) {
+    assert(new_size <= size_);
+    while (size_ > new_size)
+      slot(--size_)->~T();
+  }
+
+ private:
+  struct Chunk {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type
+        storage[kChunkSize];
+  };
+
+  T* slot(size_type index) const {
+    Chunk* chunk = chunks_[index / kChunkSize].get();
+    return reinterpret_cast<T*>(&chunk->storage[index % kChunkSize]);
+  }
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  size_type size_ = 0;
+};
+
+}  // namespace wabt
+
+#endif /* WABT_OBJECT_ARENA_H_ */
@@ -106,6 +106,11 @@ bool Opcode::IsEnabled(const Features& features) const {
     case Opcode::I64TruncUSatF64:
       return features.sat_float_to_int_enabled();
 
+    case Opcode::MemoryInit:
+    case Opcode::MemoryCopy:
+    case Opcode::MemoryFill:
+      return features.bulk_memory_enabled();
+
     case Opcode::I32Extend8S:
     case Opcode::I32Extend16S:
     case Opcode::I64Extend8S:
@@ -185,6 +190,7 @@ bool Opcode::IsEnabled(const Features& features) const {
     case Opcode::InterpCallHost:
     case Opcode::InterpData:
     case Opcode::InterpDropKeep:
+    case Opcode::InterpCompileFunc:
       return false;
 
     default:
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "src/mapped-file.h"
+
+namespace wabt {
+namespace interp {
+
+namespace {
+
+const char kSnapshotMagic[4] = {'W', 'S', 'S', 'N'};
+
+/* Snapshot file layout: header, globals, table entries, then the memory
+ * bytes at memory_offset, which is page aligned so that they can be mapped
+ * directly. */
+struct SnapshotHeader {
+  char magic[4];
+  uint32_t version;
+  CodeCacheKey key;
+  uint32_t num_globals;
+  uint32_t table_size;
+  uint32_t has_memory;
+  uint32_t memory_pages;
+  uint64_t memory_offset;
+  uint64_t memory_size;
+};
+
+struct SnapshotGlobal {
+  Type type;
+  uint32_t padding;
+  Value value;
+};
+
+uint64_t AlignUp(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // end anonymous namespace
+
+std::string GetSnapshotPath(const std::string& module_filename) {
+  return module_filename + ".snapshot";
+}
+
+wabt::Result WriteSnapshot(const std::string& filename,
+                           const CodeCacheKey& key,
+                           Instance* instance) {
+  DefinedModule* module = instance->module();
+  std::vector<SnapshotGlobal> globals(module->defined_global_count);
+  for (Index i = 0; i < module->defined_global_count; ++i) {
+    Global* global = instance->GetGlobal(module->defined_global_start + i);
+    memset(&globals[i], 0, sizeof(SnapshotGlobal));
+    globals[i].type = global->typed_value.type;
+    globals[i].value = global->typed_value.value;
+  }
+
+  const std::vector<Index>* table_entries = nullptr;
+  if (module->defined_table_index != kInvalidIndex) {
+    Table* table = instance->GetTable(module->defined_table_index);
+    table_entries = &table->func_indexes;
+  }
+
+  Memory* memory = nullptr;
+  if (module->defined_memory_index != kInvalidIndex)
+    memory = instance->GetMemory(module->defined_memory_index);
+
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+  header.version = kSnapshotVersion;
+  header.key = key;
+  header.num_globals = globals.size();
+  header.table_size = table_entries ? table_entries->size() : 0;
+  header.has_memory = memory != nullptr;
+  header.memory_pages = memory ? memory->page_limits.initial : 0;
+  header.memory_offset =
+      AlignUp(sizeof(header) + globals.size() * sizeof(SnapshotGlobal) +
+                  header.table_size * sizeof(Index),
+              WABT_PAGE_SIZE);
+  header.memory_size = memory ? memory->data.size() : 0;
+
+  return WriteFileAtomically(filename, [&](FILE* file) {
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !globals.empty())
+      ok = fwrite(globals.data(), sizeof(SnapshotGlobal), globals.size(),
+                  file) == globals.size();
+    if (ok && header.table_size != 0)
+      ok = fwrite(table_entries->data(), sizeof(Index), table_entries->size(),
+                  file) == table_entries->size();
+    /* Seeking past the end leaves the padding as a hole. */
+    if (ok && header.memory_size != 0) {
+      memory->data.FillLazyRange(0, header.memory_size);
+      ok = fseek(file, header.memory_offset, SEEK_SET) == 0 &&
+           fwrite(memory->data.data(), header.memory_size, 1, file) == 1;
+    }
+    return ok;
+  });
+}
+
+wabt::Result ReadSnapshot(const std::string& filename,
+                          const CodeCacheKey& key,
+                          CompiledModule* module) {
+  std::unique_ptr<MappedFile> file;
+  CHECK_RESULT(MappedFile::Open(filename.c_str(), &file));
+
+  const uint8_t* data = file->data();
+  size_t size = file->size();
+  if (size < sizeof(SnapshotHeader))
+    return wabt::Result::Error;
+
+  SnapshotHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+      header.version != kSnapshotVersion || !KeysEqual(header.key, key)) {
+    return wabt::Result::Error;
+  }
+
+  DefinedModule* defined_module = module->module();
+  bool has_memory = defined_module->defined_memory_index != kInvalidIndex;
+  size_t table_size = module->table_.func_indexes.size();
+  if (header.num_globals != module->globals_.size() ||
+      header.table_size != table_size ||
+      header.has_memory != static_cast<uint32_t>(has_memory)) {
+    return wabt::Result::Error;
+  }
+
+  const Limits& page_limits = module->memory_.page_limits;
+  uint64_t max_pages = page_limits.has_max ? page_limits.max : WABT_MAX_PAGES;
+  uint64_t globals_size = uint64_t(header.num_globals) * sizeof(SnapshotGlobal);
+  uint64_t table_offset = sizeof(header) + globals_size;
+  uint64_t table_end =
+      table_offset + uint64_t(header.table_size) * sizeof(Index);
+  if (header.memory_pages > max_pages ||
+      header.memory_size != uint64_t(header.memory_pages) * WABT_PAGE_SIZE ||
+      header.memory_offset % WABT_PAGE_SIZE != 0 ||
+      header.memory_offset < table_end ||
+      (header.memory_size != 0 &&
+       header.memory_offset + header.memory_size != size)) {
+    return wabt::Result::Error;
+  }
+
+  std::vector<SnapshotGlobal> globals(header.num_globals);
+  if (!globals.empty())
+    memcpy(globals.data(), data + sizeof(header), globals_size);
+  for (Index i = 0; i < header.num_globals; ++i) {
+    if (globals[i].type != module->globals_[i].typed_value.type)
+      return wabt::Result::Error;
+  }
+
+  std::vector<Index> table_entries(header.table_size);
+  if (!table_entries.empty()) {
+    memcpy(table_entries.data(), data + table_offset,
+           table_entries.size() * sizeof(Index));
+  }
+  Index num_funcs = module->env()->GetFuncCount();
+  for (Index func_index : table_entries) {
+    if (func_index != kInvalidIndex && func_index >= num_funcs)
+      return wabt::Result::Error;
+  }
+
+  for (Index i = 0; i < header.num_globals; ++i)
+    module->globals_[i].typed_value.value = globals[i].value;
+  module->table_.func_indexes.swap(table_entries);
+
+  if (has_memory) {
+    module->memory_.page_limits.initial = header.memory_pages;
+    module->memory_image_.reset();
+    if (module->use_memory_template_ && header.memory_size != 0 &&
+        Succeeded(MemoryImage::Open(filename.c_str(), header.memory_offset,
+                                    header.memory_size,
+                                    &module->memory_image_))) {
+      module->memory_.data = MemoryBuffer();
+    } else {
+      module->memory_.data = MemoryBuffer(header.memory_size);
+      if (header.memory_size != 0) {
+        memcpy(module->memory_.data.data(), data + header.memory_offset,
+               header.memory_size);
+      }
+    }
+  }
+
+  module->initialized_ = true;
+  return wabt::Result::Ok;
+}
+
+}  // namespace interp
+}  // namespace wabt
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_SNAPSHOT_H_
+#define WABT_SNAPSHOT_H_
+
+#include <string>
+
+#include "src/code-cache.h"
+#include "src/common.h"
+#include "src/interp.h"
+
+namespace wabt {
+namespace interp {
+
+// Bump when the snapshot file layout changes.
+static const uint32_t kSnapshotVersion = 1;
+
+// A snapshot holds the memory, table and globals a module defines itself, as
+// left by Executor::Preinitialize. It is keyed like cached code, since the
+// table holds environment function indices; a snapshot only applies to the
+// same module loaded into the same environment state.
+
+// Returns the default snapshot filename for a module file.
+std::string GetSnapshotPath(const std::string& module_filename);
+
+// Writes |instance|'s state.
+wabt::Result WriteSnapshot(const std::string& filename,
+                           const CodeCacheKey& key,
+                           Instance* instance);
+
+// Makes the snapshot in |filename| |module|'s initial state, if it matches
+// |key| and the module. The memory is mapped from the file copy-on-write
+// where possible. Does not print anything on failure; a missing or stale
+// snapshot just means initializing the module again.
+wabt::Result ReadSnapshot(const std::string& filename,
+                          const CodeCacheKey& key,
+                          CompiledModule* module);
+
+}  // namespace interp
+}  // namespace wabt
+
+#endif  // WABT_SNAPSHOT_H_
@@ -18,8 +18,17 @@
 
 namespace wabt {
 
+TypeChecker::Signature::Signature(Index num_types, const Type* types)
+    : size_(num_types) {
+  if (size_ <= kInlineSize) {
+    std::copy(types, types + size_, inline_types_);
+  } else {
+    heap_types_.assign(types, types + size_);
+  }
+}
+
 TypeChecker::Label::Label(LabelType label_type,
-                          const TypeVector& sig,
+                          const Signature& sig,
                           size_t limit)
     : label_type(label_type),
       sig(sig),
@@ -71,7 +80,7 @@ Result TypeChecker::SetUnreachable() {
   return Result::Ok;
 }
 
-void TypeChecker::PushLabel(LabelType label_type, const TypeVector& sig) {
+void TypeChecker::PushLabel(LabelType label_type, const Signature& sig) {
   label_stack_.emplace_back(label_type, sig, type_stack_.size());
 }
 
@@ -121,7 +130,8 @@ void TypeChecker::PushType(Type type) {
     type_stack_.push_back(type);
 }
 
-void TypeChecker::PushTypes(const TypeVector& types) {
+template <typename Types>
+void TypeChecker::PushTypes(const Types& types) {
   for (Type type : types)
     PushType(type);
 }
@@ -142,15 +152,16 @@ Result TypeChecker::CheckType(Type actual, Type expected) {
              : Result::Error;
 }
 
-Result TypeChecker::CheckSignature(const TypeVector& sig) {
+template <typename Types>
+Result TypeChecker::CheckSignature(const Types& sig) {
   Result result = Result::Ok;
   for (size_t i = 0; i < sig.size(); ++i)
     result |= PeekAndCheckType(sig.size() - i - 1, sig[i]);
   return result;
 }
 
-Result TypeChecker::PopAndCheckSignature(const TypeVector& sig,
-                                         const char* desc) {
+template <typename Types>
+Result TypeChecker::PopAndCheckSignature(const Types& sig, const char* desc) {
   Result result = CheckSignature(sig);
   PrintStackIfFailed(result, desc, sig);
   result |= DropTypes(sig.size());
@@ -282,10 +293,20 @@ void TypeChecker::PrintStackIfFailed(Result result,
   }
 }
 
+void TypeChecker::PrintStackIfFailed(Result result,
+                                     const char* desc,
+                                     const Signature& expected) {
+  // Only build the vector on failure; labels are checked on every branch.
+  if (Failed(result)) {
+    PrintStackIfFailed(result, desc,
+                       TypeVector(expected.begin(), expected.end()));
+  }
+}
+
 Result TypeChecker::BeginFunction(const TypeVector* sig) {
   type_stack_.clear();
   label_stack_.clear();
-  PushLabel(LabelType::Func, *sig);
+  PushLabel(LabelType::Func, Signature(sig->size(), sig->data()));
   return Result::Ok;
 }
 
@@ -309,8 +330,8 @@ Result TypeChecker::OnBinary(Opcode opcode) {
   return CheckOpcode2(opcode);
 }
 
-Result TypeChecker::OnBlock(const TypeVector* sig) {
-  PushLabel(LabelType::Block, *sig);
+Result TypeChecker::OnBlock(Index num_types, const Type* sig_types) {
+  PushLabel(LabelType::Block, Signature(num_types, sig_types));
   return Result::Ok;
 }
 
@@ -476,9 +497,9 @@ Result TypeChecker::OnGrowMemory() {
   return CheckOpcode1(Opcode::GrowMemory);
 }
 
-Result TypeChecker::OnIf(const TypeVector* sig) {
+Result TypeChecker::OnIf(Index num_types, const Type* sig_types) {
   Result result = PopAndCheck1Type(Type::I32, "if");
-  PushLabel(LabelType::If, *sig);
+  PushLabel(LabelType::If, Signature(num_types, sig_types));
   return result;
 }
 
@@ -496,11 +517,23 @@ Result TypeChecker::OnLoad(Opcode opcode) {
   return CheckOpcode1(opcode);
 }
 
-Result TypeChecker::OnLoop(const TypeVector* sig) {
-  PushLabel(LabelType::Loop, *sig);
+Result TypeChecker::OnLoop(Index num_types, const Type* sig_types) {
+  PushLabel(LabelType::Loop, Signature(num_types, sig_types));
   return Result::Ok;
 }
 
+Result TypeChecker::OnMemoryCopy() {
+  return CheckOpcode3(Opcode::MemoryCopy);
+}
+
+Result TypeChecker::OnMemoryFill() {
+  return CheckOpcode3(Opcode::MemoryFill);
+}
+
+Result TypeChecker::OnMemoryInit() {
+  return CheckOpcode3(Opcode::MemoryInit);
+}
+
 Result TypeChecker::OnRethrow(Index depth) {
   Result result = Result::Ok;
   Label* label;
@@ -567,8 +600,8 @@ Result TypeChecker::OnStore(Opcode opcode) {
   return CheckOpcode2(opcode);
 }
 
-Result TypeChecker::OnTryBlock(const TypeVector* sig) {
-  PushLabel(LabelType::Try, *sig);
+Result TypeChecker::OnTryBlock(Index num_types, const Type* sig_types) {
+  PushLabel(LabelType::Try, Signature(num_types, sig_types));
   return Result::Ok;
 }
 
@@ -29,11 +29,36 @@ class TypeChecker {
  public:
   typedef std::function<void(const char* msg)> ErrorCallback;
 
+  // A label's copy of its block signature. Block signatures have at most one
+  // type, so they are stored inline and pushing a label never allocates; only
+  // longer signatures (e.g. function results) spill to the heap.
+  class Signature {
+   public:
+    Signature() = default;
+    Signature(Index num_types, const Type* types);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Type* data() const {
+      return size_ <= kInlineSize ? inline_types_ : heap_types_.data();
+    }
+    Type operator[](size_t index) const { return data()[index]; }
+    const Type* begin() const { return data(); }
+    const Type* end() const { return data() + size_; }
+
+   private:
+    static const size_t kInlineSize = 2;
+
+    size_t size_ = 0;
+    Type inline_types_[kInlineSize];
+    TypeVector heap_types_;
+  };
+
   struct Label {
-    Label(LabelType, const TypeVector& sig, size_t limit);
+    Label(LabelType, const Signature& sig, size_t limit);
 
     LabelType label_type;
-    TypeVector sig;
+    Signature sig;
     size_t type_stack_limit;
     bool unreachable;
   };
@@ -56,7 +81,7 @@ class TypeChecker {
   Result OnAtomicRmw(Opcode);
   Result OnAtomicRmwCmpxchg(Opcode);
   Result OnBinary(Opcode);
-  Result OnBlock(const TypeVector* sig);
+  Result OnBlock(Index num_types, const Type* sig_types);
   Result OnBr(Index depth);
   Result OnBrIf(Index depth);
   Result BeginBrTable();
@@ -77,9 +102,12 @@ class TypeChecker {
   Result OnGetGlobal(Type);
   Result OnGetLocal(Type);
   Result OnGrowMemory();
-  Result OnIf(const TypeVector* sig);
+  Result OnIf(Index num_types, const Type* sig_types);
   Result OnLoad(Opcode);
-  Result OnLoop(const TypeVector* sig);
+  Result OnLoop(Index num_types, const Type* sig_types);
+  Result OnMemoryCopy();
+  Result OnMemoryFill();
+  Result OnMemoryInit();
   Result OnRethrow(Index depth);
   Result OnReturn();
   Result OnSelect();
@@ -88,7 +116,7 @@ class TypeChecker {
   Result OnStore(Opcode);
   Result OnTeeLocal(Type);
   Result OnThrow(const TypeVector* sig);
-  Result OnTryBlock(const TypeVector* sig);
+  Result OnTryBlock(Index num_types, const Type* sig_types);
   Result OnUnary(Opcode);
   Result OnUnreachable();
   Result OnWait(Opcode);
@@ -100,18 +128,21 @@ class TypeChecker {
   Result TopLabel(Label** out_label);
   void ResetTypeStackToLabel(Label* label);
   Result SetUnreachable();
-  void PushLabel(LabelType label_type, const TypeVector& sig);
+  void PushLabel(LabelType label_type, const Signature& sig);
   Result PopLabel();
   Result CheckLabelType(Label* label, LabelType label_type);
   Result PeekType(Index depth, Type* out_type);
   Result PeekAndCheckType(Index depth, Type expected);
   Result DropTypes(size_t drop_count);
   void PushType(Type type);
-  void PushTypes(const TypeVector& types);
+  template <typename Types>
+  void PushTypes(const Types& types);
   Result CheckTypeStackEnd(const char* desc);
   Result CheckType(Type actual, Type expected);
-  Result CheckSignature(const TypeVector& sig);
-  Result PopAndCheckSignature(const TypeVector& sig, const char* desc);
+  template <typename Types>
+  Result CheckSignature(const Types& sig);
+  template <typename Types>
+  Result PopAndCheckSignature(const Types& sig, const char* desc);
   Result PopAndCheckCall(const TypeVector& param_types,
                          const TypeVector& result_types,
                          const char* desc);
@@ -131,10 +162,11 @@ class TypeChecker {
     // Minor optimzation, check result before constructing the vector to pass
     // to the other overload of PrintStackIfFailed.
     if (Failed(result))
-      PrintStackIfFailed(result, desc, {args...});
+      PrintStackIfFailed(result, desc, TypeVector{args...});
   }
 
   void PrintStackIfFailed(Result, const char* desc, const TypeVector&);
+  void PrintStackIfFailed(Result, const char* desc, const Signature&);
 
   ErrorCallback error_callback_;
   TypeVector type_stack_;
@@ -0,0 +1,391 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/wasmscript.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/cast.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+static_assert(sizeof(wasmscript_val_t) == sizeof(Value) &&
+                  alignof(wasmscript_val_t) == alignof(Value),
+              "wasmscript_val_t must have the layout of interp::Value");
+
+namespace {
+
+const Index kMaxInlineValues = 16;
+
+struct HostFuncDef {
+  TypeVector param_types;
+  TypeVector result_types;
+  wasmscript_host_func_t callback;
+  void* user_data;
+};
+
+struct HostMemoryDef {
+  char* data;  // Not owned.
+  size_t size;
+};
+
+bool ValKindToType(wasmscript_valkind_t kind, Type* out_type) {
+  switch (kind) {
+    case WASMSCRIPT_I32: *out_type = Type::I32; return true;
+    case WASMSCRIPT_I64: *out_type = Type::I64; return true;
+    case WASMSCRIPT_F32: *out_type = Type::F32; return true;
+    case WASMSCRIPT_F64: *out_type = Type::F64; return true;
+  }
+  return false;
+}
+
+wasmscript_valkind_t TypeToValKind(Type type) {
+  switch (type) {
+    case Type::I64: return WASMSCRIPT_I64;
+    case Type::F32: return WASMSCRIPT_F32;
+    case Type::F64: return WASMSCRIPT_F64;
+    default: assert(type == Type::I32); return WASMSCRIPT_I32;
+  }
+}
+
+// The HostFuncCallback of every function defined through the C API; unpacks
+// the typed values into the plain arrays the C callback takes.
+interp::Result HostFuncThunk(const HostFunc* func,
+                             const FuncSignature* sig,
+                             Index num_args,
+                             TypedValue* args,
+                             Index num_results,
+                             TypedValue* out_results,
+                             void* user_data) {
+  auto* def = static_cast<HostFuncDef*>(user_data);
+  wasmscript_val_t inline_values[kMaxInlineValues];
+  std::vector<wasmscript_val_t> heap_values;
+  wasmscript_val_t* values = inline_values;
+  if (num_args + num_results > kMaxInlineValues) {
+    heap_values.resize(num_args + num_results);
+    values = heap_values.data();
+  }
+
+  for (Index i = 0; i < num_args; ++i)
+    memcpy(&values[i], &args[i].value, sizeof(Value));
+  wasmscript_val_t* results = values + num_args;
+  wasmscript_result_t result = def->callback(def->user_data, values, results);
+  if (result != WASMSCRIPT_OK)
+    return static_cast<interp::Result>(result);
+
+  for (Index i = 0; i < num_results; ++i) {
+    out_results[i].type = sig->result_types[i];
+    memcpy(&out_results[i].value, &results[i], sizeof(Value));
+  }
+  return interp::Result::Ok;
+}
+
+class CApiImportDelegate : public HostImportDelegate {
+ public:
+  void DefineFunc(string_view name, std::unique_ptr<HostFuncDef> def) {
+    funcs_[name.to_string()] = def.get();
+    defs_.push_back(std::move(def));
+  }
+
+  void DefineMemory(string_view name, const HostMemoryDef& def) {
+    memories_[name.to_string()] = def;
+  }
+
+  wabt::Result ImportFunc(FuncImport* import,
+                          Func* func,
+                          FuncSignature* sig,
+                          const ErrorCallback& callback) override {
+    auto iter = funcs_.find(import->field_name);
+    if (iter == funcs_.end()) {
+      return PrintUnknownImport(import, callback);
+    }
+    HostFuncDef* def = iter->second;
+    if (sig->param_types != def->param_types ||
+        sig->result_types != def->result_types) {
+      callback("import signature mismatch");
+      return wabt::Result::Error;
+    }
+    cast<HostFunc>(func)->callback = HostFuncThunk;
+    cast<HostFunc>(func)->user_data = def;
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result ImportTable(TableImport* import,
+                           Table*,
+                           const ErrorCallback& callback) override {
+    return PrintUnknownImport(import, callback);
+  }
+
+  wabt::Result ImportMemory(MemoryImport* import,
+                            Memory* memory,
+                            const ErrorCallback& callback) override {
+    auto iter = memories_.find(import->field_name);
+    if (iter == memories_.end()) {
+      return PrintUnknownImport(import, callback);
+    }
+    // Every importer wraps the same bytes; since the memory can't grow,
+    // they all see the same size too.
+    const HostMemoryDef& def = iter->second;
+    memory->page_limits.initial = memory->page_limits.max =
+        def.size / WABT_PAGE_SIZE;
+    memory->page_limits.has_max = true;
+    memory->data = MemoryBuffer::Borrow(def.data, def.size);
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result ImportGlobal(GlobalImport* import,
+                            Global*,
+                            const ErrorCallback& callback) override {
+    return PrintUnknownImport(import, callback);
+  }
+
+ private:
+  wabt::Result PrintUnknownImport(const Import* import,
+                                  const ErrorCallback& callback) {
+    std::string message = "unknown host import " + import->module_name + "." +
+                          import->field_name;
+    callback(message.c_str());
+    return wabt::Result::Error;
+  }
+
+  std::vector<std::unique_ptr<HostFuncDef>> defs_;
+  // A name that is defined again maps to the new definition; functions
+  // imported earlier keep the old one.
+  std::map<std::string, HostFuncDef*> funcs_;
+  std::map<std::string, HostMemoryDef> memories_;
+};
+
+}  // end anonymous namespace
+
+struct wasmscript_engine {
+  wasmscript_engine() : executor(&env) {}
+
+  Environment env;
+  Executor executor;
+  std::map<std::string, CApiImportDelegate*> host_modules;
+};
+
+struct wasmscript_module {
+  wasmscript_engine_t* engine;
+  Index module_index;
+  // Shared with the module's instances, which may outlive the handle.
+  std::shared_ptr<CompiledModule> compiled;
+};
+
+struct wasmscript_instance {
+  wasmscript_engine_t* engine;
+  std::shared_ptr<CompiledModule> compiled;
+  std::unique_ptr<Instance> instance;
+};
+
+struct wasmscript_func {
+  wasmscript_engine_t* engine;
+  ExportHandle handle;
+};
+
+const char* wasmscript_result_string(wasmscript_result_t result) {
+#define V(Name, str) +1
+  const int kNumResults = 0 FOREACH_INTERP_RESULT(V);
+#undef V
+  if (result < 0 || result >= kNumResults)
+    return "unknown result";
+  return ResultToString(static_cast<interp::Result>(result));
+}
+
+// Returns the delegate of the host module named |name|, creating it if needed.
+static CApiImportDelegate* GetHostModule(wasmscript_engine_t* engine,
+                                         const char* name) {
+  CApiImportDelegate*& delegate = engine->host_modules[name];
+  if (!delegate) {
+    HostModule* module = engine->env.AppendHostModule(name);
+    delegate = new CApiImportDelegate();
+    module->import_delegate.reset(delegate);
+  }
+  return delegate;
+}
+
+wasmscript_engine_t* wasmscript_engine_new(void) {
+  return new wasmscript_engine();
+}
+
+void wasmscript_engine_delete(wasmscript_engine_t* engine) {
+  delete engine;
+}
+
+wasmscript_result_t wasmscript_engine_define_func(
+    wasmscript_engine_t* engine,
+    const char* module_name,
+    const char* field_name,
+    const wasmscript_valkind_t* params,
+    size_t num_params,
+    const wasmscript_valkind_t* results,
+    size_t num_results,
+    wasmscript_host_func_t callback,
+    void* user_data) {
+  std::unique_ptr<HostFuncDef> def(new HostFuncDef());
+  def->param_types.resize(num_params);
+  def->result_types.resize(num_results);
+  for (size_t i = 0; i < num_params; ++i) {
+    if (!ValKindToType(params[i], &def->param_types[i]))
+      return static_cast<wasmscript_result_t>(
+          interp::Result::ArgumentTypeMismatch);
+  }
+  for (size_t i = 0; i < num_results; ++i) {
+    if (!ValKindToType(results[i], &def->result_types[i]))
+      return static_cast<wasmscript_result_t>(
+          interp::Result::ArgumentTypeMismatch);
+  }
+  def->callback = callback;
+  def->user_data = user_data;
+  GetHostModule(engine, module_name)->DefineFunc(field_name, std::move(def));
+  return WASMSCRIPT_OK;
+}
+
+wasmscript_result_t wasmscript_engine_define_memory(wasmscript_engine_t* engine,
+                                                    const char* module_name,
+                                                    const char* field_name,
+                                                    void* data,
+                                                    size_t size) {
+  if (size % WABT_PAGE_SIZE != 0)
+    return static_cast<wasmscript_result_t>(interp::Result::InvalidMemorySize);
+  GetHostModule(engine, module_name)
+      ->DefineMemory(field_name, HostMemoryDef{static_cast<char*>(data), size});
+  return WASMSCRIPT_OK;
+}
+
+wasmscript_module_t* wasmscript_module_compile(wasmscript_engine_t* engine,
+                                               const uint8_t* data,
+                                               size_t size,
+                                               char** out_error) {
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  ReadBinaryOptions options(Features(), nullptr, kReadDebugNames,
+                            kStopOnFirstError);
+  DefinedModule* module = nullptr;
+  wabt::Result result = ReadBinaryInterp(&engine->env, data, size, &options,
+                                         &error_handler, &module);
+  if (Failed(result)) {
+    if (out_error) {
+      const std::string& message = error_handler.buffer();
+      *out_error = static_cast<char*>(malloc(message.size() + 1));
+      memcpy(*out_error, message.c_str(), message.size() + 1);
+    }
+    return nullptr;
+  }
+  return new wasmscript_module{
+      engine, engine->env.GetLastModuleIndex(),
+      std::make_shared<CompiledModule>(&engine->env, module)};
+}
+
+void wasmscript_module_delete(wasmscript_module_t* module) {
+  delete module;
+}
+
+wasmscript_result_t wasmscript_module_register(wasmscript_module_t* module,
+                                               const char* name) {
+  Environment* env = &module->engine->env;
+  if (env->FindRegisteredModule(name))
+    return static_cast<wasmscript_result_t>(interp::Result::ModuleNameInUse);
+  env->EmplaceRegisteredModuleBinding(name, Binding(module->module_index));
+  module->compiled->set_shares_memory(true);
+  return WASMSCRIPT_OK;
+}
+
+wasmscript_result_t wasmscript_instance_new(wasmscript_module_t* module,
+                                            wasmscript_instance_t** out) {
+  std::unique_ptr<Instance> instance;
+  interp::Result result =
+      module->engine->executor.Instantiate(module->compiled.get(), &instance);
+  if (result != interp::Result::Ok)
+    return static_cast<wasmscript_result_t>(result);
+  *out = new wasmscript_instance{module->engine, module->compiled,
+                                 std::move(instance)};
+  return WASMSCRIPT_OK;
+}
+
+void wasmscript_instance_delete(wasmscript_instance_t* instance) {
+  delete instance;
+}
+
+wasmscript_result_t wasmscript_instance_reset(wasmscript_instance_t* instance) {
+  return static_cast<wasmscript_result_t>(
+      instance->engine->executor.ResetInstance(instance->instance.get()));
+}
+
+wasmscript_func_t* wasmscript_instance_get_func(wasmscript_instance_t* instance,
+                                                const char* name) {
+  ExportHandle handle;
+  if (instance->engine->executor.ResolveExport(instance->instance.get(), name,
+                                               &handle) != interp::Result::Ok) {
+    return nullptr;
+  }
+  return new wasmscript_func{instance->engine, handle};
+}
+
+void wasmscript_func_delete(wasmscript_func_t* func) {
+  delete func;
+}
+
+void wasmscript_func_type(const wasmscript_func_t* func,
+                          size_t* out_num_params,
+                          size_t* out_num_results) {
+  if (out_num_params)
+    *out_num_params = func->handle.num_params;
+  if (out_num_results)
+    *out_num_results = func->handle.num_results;
+}
+
+wasmscript_valkind_t wasmscript_func_param(const wasmscript_func_t* func,
+                                           size_t index) {
+  return TypeToValKind(func->handle.sig->param_types[index]);
+}
+
+wasmscript_valkind_t wasmscript_func_result(const wasmscript_func_t* func,
+                                            size_t index) {
+  return TypeToValKind(func->handle.sig->result_types[index]);
+}
+
+wasmscript_result_t wasmscript_func_call(wasmscript_func_t* func,
+                                         const wasmscript_val_t* args,
+                                         wasmscript_val_t* results) {
+  return static_cast<wasmscript_result_t>(func->engine->executor.Call(
+      func->handle, reinterpret_cast<const Value*>(args),
+      reinterpret_cast<Value*>(results)));
+}
+
+uint8_t* wasmscript_memory_data(wasmscript_instance_t* instance,
+                                size_t* out_size) {
+  Index memory_index = instance->instance->module()->memory_index;
+  if (memory_index == kInvalidIndex) {
+    *out_size = 0;
+    return nullptr;
+  }
+  Memory* memory = instance->instance->GetMemory(memory_index);
+  *out_size = memory->data.size();
+  return reinterpret_cast<uint8_t*>(memory->data.data());
+}
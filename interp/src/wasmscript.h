@@ -0,0 +1,171 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WABT_WASMSCRIPT_H_
+#define WABT_WASMSCRIPT_H_
+
+/*
+ * A C API for embedding the interpreter.
+ *
+ * An engine owns everything: the environment with its host functions, the
+ * compiled code of every module, and the executor that runs calls. Engines
+ * are independent of each other; a single engine must only be used by one
+ * thread at a time.
+ *
+ * Values cross the boundary as plain arrays of wasmscript_val_t, without type
+ * tags; the caller is responsible for passing the types in the function's
+ * signature (see wasmscript_func_type). Exported functions are resolved once
+ * to a wasmscript_func_t, after which calls do no name lookup, no type
+ * checking and no allocation.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct wasmscript_engine wasmscript_engine_t;
+typedef struct wasmscript_module wasmscript_module_t;
+typedef struct wasmscript_instance wasmscript_instance_t;
+typedef struct wasmscript_func wasmscript_func_t;
+
+typedef enum wasmscript_valkind {
+  WASMSCRIPT_I32,
+  WASMSCRIPT_I64,
+  WASMSCRIPT_F32,
+  WASMSCRIPT_F64
+} wasmscript_valkind_t;
+
+/* Has the same layout as the interpreter's own values, so arrays of them are
+ * passed through without conversion. */
+typedef union wasmscript_val {
+  uint32_t i32;
+  uint64_t i64;
+  float f32;
+  double f64;
+} wasmscript_val_t;
+
+/* 0 on success; otherwise the interpreter's trap or error code, which
+ * wasmscript_result_string describes. */
+typedef int wasmscript_result_t;
+#define WASMSCRIPT_OK 0
+
+const char* wasmscript_result_string(wasmscript_result_t);
+
+/* A host function. |args| holds one value per parameter of the signature it
+ * was defined with, and it must write one value per result to |results|.
+ * Returning anything but WASMSCRIPT_OK traps the calling guest code. The
+ * function may call back into the guest with wasmscript_func_call. */
+typedef wasmscript_result_t (*wasmscript_host_func_t)(
+    void* user_data,
+    const wasmscript_val_t* args,
+    wasmscript_val_t* results);
+
+wasmscript_engine_t* wasmscript_engine_new(void);
+void wasmscript_engine_delete(wasmscript_engine_t*);
+
+/* Makes |module_name|.|field_name| available to modules compiled later. */
+wasmscript_result_t wasmscript_engine_define_func(
+    wasmscript_engine_t*,
+    const char* module_name,
+    const char* field_name,
+    const wasmscript_valkind_t* params,
+    size_t num_params,
+    const wasmscript_valkind_t* results,
+    size_t num_results,
+    wasmscript_host_func_t callback,
+    void* user_data);
+
+/* Makes the |size| bytes at |data| available to modules compiled later as
+ * memory |module_name|.|field_name|, without copying them: guest code reads
+ * and writes |data| directly, so it must stay valid as long as the engine.
+ * Every importing module sees the same bytes, which can therefore serve as a
+ * shared arena; that holds however many modules, memories and instances are
+ * added to the engine afterwards. |size| must be a multiple of the 64 KiB
+ * page size, and the memory can't grow. */
+wasmscript_result_t wasmscript_engine_define_memory(wasmscript_engine_t*,
+                                                    const char* module_name,
+                                                    const char* field_name,
+                                                    void* data,
+                                                    size_t size);
+
+/* Validates and compiles a binary module, resolving its imports. On failure
+ * returns NULL and, if |out_error| is not NULL, stores a message there that
+ * the caller must free(). |data| need not outlive the call. */
+wasmscript_module_t* wasmscript_module_compile(wasmscript_engine_t*,
+                                               const uint8_t* data,
+                                               size_t size,
+                                               char** out_error);
+/* Frees the handle. The module's code stays in the engine until the engine
+ * is deleted. */
+void wasmscript_module_delete(wasmscript_module_t*);
+
+/* Makes the module's exports importable as |name|.<export> by modules
+ * compiled later. The module's own memory, if it has one, becomes shared:
+ * instances created from then on and the modules importing it all use a
+ * single memory rather than a copy per instance. */
+wasmscript_result_t wasmscript_module_register(wasmscript_module_t*,
+                                               const char* name);
+
+/* Creates an instance with its own copy of the memory, table and globals the
+ * module defines, initialized as they were when the module was compiled, and
+ * runs the module's start function in it. Imported memories, tables and
+ * globals, and the memory of a registered module, are shared by all
+ * instances. The instance keeps the compiled module
+ * alive, so the module handle may be deleted first. */
+wasmscript_result_t wasmscript_instance_new(wasmscript_module_t*,
+                                            wasmscript_instance_t** out);
+void wasmscript_instance_delete(wasmscript_instance_t*);
+
+/* Returns the instance to the state wasmscript_instance_new left it in,
+ * running the start function again. Restoring the memory costs roughly the
+ * pages written since the instance was created or last reset. */
+wasmscript_result_t wasmscript_instance_reset(wasmscript_instance_t*);
+
+/* Returns NULL if there is no exported function named |name|. Calls through
+ * the handle run in |instance|, so it must be deleted before the instance. */
+wasmscript_func_t* wasmscript_instance_get_func(wasmscript_instance_t*,
+                                                const char* name);
+void wasmscript_func_delete(wasmscript_func_t*);
+
+/* Reports the function's signature. Either pointer may be NULL. */
+void wasmscript_func_type(const wasmscript_func_t*,
+                          size_t* out_num_params,
+                          size_t* out_num_results);
+wasmscript_valkind_t wasmscript_func_param(const wasmscript_func_t*,
+                                           size_t index);
+wasmscript_valkind_t wasmscript_func_result(const wasmscript_func_t*,
+                                            size_t index);
+
+/* Calls |func| with one argument per parameter and writes one value per
+ * result. Argument types are not checked. */
+wasmscript_result_t wasmscript_func_call(wasmscript_func_t* func,
+                                         const wasmscript_val_t* args,
+                                         wasmscript_val_t* results);
+
+/* Returns the instance's linear memory and stores its size in bytes in
+ * |out_size|, or returns NULL if it has none. The pointer is invalidated by
+ * anything that can grow the memory, i.e. any call into the guest. */
+uint8_t* wasmscript_memory_data(wasmscript_instance_t*, size_t* out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WABT_WASMSCRIPT_H_ */
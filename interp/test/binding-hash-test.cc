@@ -0,0 +1,142 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// BindingHash lookups must survive erasures in the middle of a probe run
+// (backward-shift deletion), including runs that wrap around the end of the
+// slot table, and names may be bound more than once.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/binding-hash.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+
+namespace {
+
+// Binds |name| with an explicit hash, so that tests can force collisions.
+void Bind(BindingHash* hash, const std::string& name, hash_code h) {
+  hash->emplace(name, h, Binding(static_cast<Index>(hash->size())));
+}
+
+bool Contains(const BindingHash& hash, const std::string& name, hash_code h) {
+  return hash.find(name, h) != hash.end();
+}
+
+// Names that all start probing at the last slot of the initial 8-slot table,
+// so their run wraps around to slot 0.
+void TestCollidingErase() {
+  const hash_code kHashes[] = {7, 7, 15, 7, 6, 0};
+  const char* kNames[] = {"a", "b", "c", "d", "e", "f"};
+  BindingHash hash;
+  for (int i = 0; i < 6; ++i)
+    Bind(&hash, kNames[i], kHashes[i]);
+
+  // Erase entries from the middle of the run, checking the rest each time.
+  const int kEraseOrder[] = {1, 0, 4, 3, 5, 2};
+  bool erased[6] = {};
+  for (int victim : kEraseOrder) {
+    auto iter = hash.find(kNames[victim], kHashes[victim]);
+    CHECK(iter != hash.end());
+    hash.erase(iter);
+    erased[victim] = true;
+    for (int i = 0; i < 6; ++i)
+      CHECK(Contains(hash, kNames[i], kHashes[i]) == !erased[i]);
+  }
+  CHECK(hash.empty());
+}
+
+// erase(iterator) moves the last entry into the erased one's place and
+// returns an iterator to it.
+void TestEraseIterator() {
+  BindingHash hash;
+  hash.emplace("x", Binding(0));
+  hash.emplace("y", Binding(1));
+  hash.emplace("z", Binding(2));
+  auto iter = hash.erase(hash.find("x"));
+  CHECK(iter == hash.begin());
+  CHECK(iter->first == "z");
+  CHECK(hash.FindIndex(string_view("z")) == 2);
+  CHECK(hash.FindIndex(string_view("y")) == 1);
+  CHECK(hash.FindIndex(string_view("x")) == kInvalidIndex);
+
+  iter = hash.erase(hash.find("y"));
+  CHECK(iter == hash.end());
+  CHECK(hash.size() == 1);
+}
+
+// Duplicate bindings are all counted, reported and erased.
+void TestDuplicates() {
+  BindingHash hash;
+  hash.emplace("dup", Binding(Location("f", 1, 1, 2), 0));
+  hash.emplace("one", Binding(Location("f", 2, 1, 2), 1));
+  hash.emplace("dup", Binding(Location("f", 3, 1, 2), 2));
+  CHECK(hash.count("dup") == 2);
+  CHECK(hash.count("one") == 1);
+  CHECK(hash.count("none") == 0);
+
+  int calls = 0;
+  hash.FindDuplicates([&](const BindingHash::value_type& first,
+                          const BindingHash::value_type& dup) {
+    CHECK(first.first == "dup" && dup.first == "dup");
+    CHECK(first.second.index == 0 && dup.second.index == 2);
+    ++calls;
+  });
+  CHECK(calls == 1);
+
+  CHECK(hash.erase("dup") == 2);
+  CHECK(hash.count("dup") == 0);
+  CHECK(hash.erase("dup") == 0);
+  CHECK(hash.FindIndex(string_view("one")) == 1);
+}
+
+// Random emplaces and erases of a few names, checked against a std::map.
+void TestRandomOperations() {
+  BindingHash hash;
+  std::map<std::string, size_t> counts;
+  uint32_t state = 1;
+  for (int op = 0; op < 20000; ++op) {
+    state = state * 1103515245 + 12345;
+    std::string name = "n" + std::to_string((state >> 16) % 37);
+    if ((state >> 8) % 3 == 0) {
+      CHECK(hash.erase(name) == counts[name]);
+      counts[name] = 0;
+    } else {
+      hash.emplace(name, Binding(0));
+      ++counts[name];
+    }
+  }
+
+  size_t total = 0;
+  for (const auto& pair : counts) {
+    CHECK(hash.count(pair.first) == pair.second);
+    CHECK((hash.find(pair.first) != hash.end()) == (pair.second != 0));
+    total += pair.second;
+  }
+  CHECK(hash.size() == total);
+}
+
+}  // end anonymous namespace
+
+int main() {
+  TestCollidingErase();
+  TestEraseIterator();
+  TestDuplicates();
+  TestRandomOperations();
+  return 0;
+}
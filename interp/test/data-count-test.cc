@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+namespace {
+
+// (module
+//   (memory 1)
+//   (func (export "f") (memory.init 0 (i32.const 0) (i32.const 0)
+//                                     (i32.const 1)))
+//   (data passive "x"))
+// without a data count section, so memory.init is invalid.
+const uint8_t kNoDataCount[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01, 0x60,
+    0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x05, 0x03, 0x01, 0x00, 0x01, 0x07,
+    0x05, 0x01, 0x01, 0x66, 0x00, 0x00, 0x0a, 0x0e, 0x01, 0x0c, 0x00, 0x41,
+    0x00, 0x41, 0x00, 0x41, 0x01, 0xfc, 0x08, 0x00, 0x00, 0x0b, 0x0b, 0x04,
+    0x01, 0x01, 0x01, 0x78,
+};
+
+// The same module with a data count section.
+const uint8_t kDataCount[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01, 0x60,
+    0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x05, 0x03, 0x01, 0x00, 0x01, 0x07,
+    0x05, 0x01, 0x01, 0x66, 0x00, 0x00, 0x0c, 0x01, 0x01, 0x0a, 0x0e, 0x01,
+    0x0c, 0x00, 0x41, 0x00, 0x41, 0x00, 0x41, 0x01, 0xfc, 0x08, 0x00, 0x00,
+    0x0b, 0x0b, 0x04, 0x01, 0x01, 0x01, 0x78,
+};
+
+enum class Mode { Serial, Deferred, Parallel };
+
+// Reads the module and calls "f"; returns whether both succeeded.
+bool ReadAndRun(const uint8_t* data, size_t size, Mode mode) {
+  Environment env;
+  ReadBinaryOptions options;
+  options.features.enable_bulk_memory();
+  options.defer_function_bodies = mode == Mode::Deferred;
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* module = nullptr;
+  int num_threads = mode == Mode::Parallel ? 2 : 1;
+  if (Failed(ReadBinaryInterpParallel(&env, data, size, &options, num_threads,
+                                      &error_handler, &module))) {
+    return false;
+  }
+
+  Executor executor(&env);
+  if (executor.RunStartFunction(module).result != interp::Result::Ok)
+    return false;
+  ExecResult result = executor.RunExport(module->GetExport("f"), {});
+  if (result.result != interp::Result::Ok)
+    return false;
+  CHECK(env.GetMemory(module->memory_index)->data[0] == 'x');
+  return true;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  for (Mode mode : {Mode::Serial, Mode::Deferred, Mode::Parallel}) {
+    CHECK(!ReadAndRun(kNoDataCount, sizeof(kNoDataCount), mode));
+    CHECK(ReadAndRun(kDataCount, sizeof(kDataCount), mode));
+  }
+  return 0;
+}
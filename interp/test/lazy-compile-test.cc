@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// With ReadBinaryOptions::defer_function_bodies, each function is compiled
+// the first time it is called, and a body that fails validation traps
+// instead of failing the read.
+
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/cast.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+namespace {
+
+// (module
+//   (func $g (param i32) (result i32) (i32.add (local.get 0) (i32.const 1)))
+//   (func (export "f") (param i32) (result i32)
+//     (i32.mul (call $g (local.get 0)) (i32.const 2)))
+//   (func (export "h") (result i32) (i32.const 7))
+//   (func (export "bad") (result i32) (i64.const 0)))
+// "bad" does not validate.
+const uint8_t kModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0a, 0x02, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x60, 0x00, 0x01, 0x7f, 0x03, 0x05, 0x04, 0x00,
+    0x00, 0x01, 0x01, 0x07, 0x0f, 0x03, 0x01, 0x66, 0x00, 0x01, 0x01, 0x68,
+    0x00, 0x02, 0x03, 0x62, 0x61, 0x64, 0x00, 0x03, 0x0a, 0x1d, 0x04, 0x07,
+    0x00, 0x20, 0x00, 0x41, 0x01, 0x6a, 0x0b, 0x09, 0x00, 0x20, 0x00, 0x10,
+    0x00, 0x41, 0x02, 0x6c, 0x0b, 0x04, 0x00, 0x41, 0x07, 0x0b, 0x04, 0x00,
+    0x42, 0x00, 0x0b,
+};
+
+bool IsCompiled(Environment* env, Index func_index) {
+  return cast<DefinedFunc>(env->GetFunc(func_index))->lazy_compiler == nullptr;
+}
+
+uint32_t RunI32(Executor* executor, const Export* export_, uint32_t arg) {
+  Value value;
+  value.i32 = arg;
+  ExecResult result =
+      executor->RunExport(export_, {TypedValue(Type::I32, value)});
+  CHECK(result.result == interp::Result::Ok);
+  CHECK(result.values.size() == 1);
+  return result.values[0].value.i32;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  Environment env;
+  ReadBinaryOptions options;
+  options.defer_function_bodies = true;
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* module = nullptr;
+  CHECK(Succeeded(ReadBinaryInterp(&env, kModule, sizeof(kModule), &options,
+                                   &error_handler, &module)));
+  CHECK(module->lazy_compiler);
+
+  const Export* f = module->GetExport("f");
+  const Export* h = module->GetExport("h");
+  const Export* bad = module->GetExport("bad");
+  CHECK(!IsCompiled(&env, f->index));
+  CHECK(!IsCompiled(&env, h->index));
+  CHECK(!IsCompiled(&env, bad->index));
+
+  // Calling "f" compiles it and its callee $g, but nothing else.
+  Executor executor(&env);
+  CHECK(RunI32(&executor, f, 20) == 42);
+  CHECK(IsCompiled(&env, f->index));
+  CHECK(IsCompiled(&env, f->index - 1));
+  CHECK(!IsCompiled(&env, h->index));
+
+  // Later calls run the patched stubs.
+  CHECK(RunI32(&executor, f, 1) == 4);
+
+  ExecResult result = executor.RunExport(h, {});
+  CHECK(result.result == interp::Result::Ok);
+  CHECK(result.values[0].value.i32 == 7);
+
+  result = executor.RunExport(bad, {});
+  CHECK(result.result == interp::Result::TrapLazyCompileFailed);
+  CHECK(!IsCompiled(&env, bad->index));
+  return 0;
+}
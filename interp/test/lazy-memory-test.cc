@@ -0,0 +1,102 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "src/memory-buffer.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+
+namespace {
+
+const size_t kSize = 16 * kLazyChunkSize;
+
+void MakeLazy(MemoryBuffer* buffer, const std::vector<char>& bytes) {
+  buffer->UseLazyMapping(kSize, kSize);
+  buffer->SetLazySegments({LazySegment(0, bytes.data(), bytes.size())});
+}
+
+// Bytes of a pending chunk passed to write() must be filled in first.
+void TestSystemCall(const std::vector<char>& bytes) {
+  MemoryBuffer buffer;
+  MakeLazy(&buffer, bytes);
+  CHECK(buffer.GetLazyPendingBytes() == kSize);
+
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  size_t offset = 3 * kLazyChunkSize + 10;
+  buffer.FillLazyRange(offset, 100);
+  CHECK(buffer.GetLazyPendingBytes() == kSize - kLazyChunkSize);
+  CHECK(write(fds[1], buffer.data() + offset, 100) == 100);
+  char out[100];
+  CHECK(read(fds[0], out, sizeof(out)) == 100);
+  CHECK(memcmp(out, &bytes[offset], sizeof(out)) == 0);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// Growing a vector of buffers moves them, leaving their chunks pending.
+void TestVectorGrowth(const std::vector<char>& bytes) {
+  std::vector<MemoryBuffer> buffers(1);
+  MakeLazy(&buffers[0], bytes);
+  const char* data = buffers[0].data();
+  for (int i = 0; i < 64; ++i)
+    buffers.emplace_back(WABT_PAGE_SIZE);
+  CHECK(buffers[0].data() == data);
+  CHECK(buffers[0].GetLazyPendingBytes() == kSize);
+  CHECK(buffers[0][kSize - 1] == bytes[kSize - 1]);
+}
+
+// Regions are registered and released while other threads fault on theirs.
+void TestConcurrentRelease(const std::vector<char>& bytes) {
+  const int kThreads = 4;
+  const int kIterations = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&bytes]() {
+      for (int i = 0; i < kIterations; ++i) {
+        MemoryBuffer buffer;
+        MakeLazy(&buffer, bytes);
+        size_t offset = (i % 16) * kLazyChunkSize + i;
+        CHECK(buffer[offset] == bytes[offset]);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+}  // end anonymous namespace
+
+int main() {
+  if (!LazyMemoryAvailable())
+    return 0;
+
+  std::vector<char> bytes(kSize);
+  for (size_t i = 0; i < bytes.size(); ++i)
+    bytes[i] = static_cast<char>(i * 7 + 1);
+
+  TestSystemCall(bytes);
+  TestVectorGrowth(bytes);
+  TestConcurrentRelease(bytes);
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Growing an Environment's memories must move the existing ones, keeping
+// their storage, rather than copy them to the heap.
+
+#include <cstdint>
+#include <memory>
+
+#include "src/huge-pages.h"
+#include "src/interp.h"
+#include "src/memory-buffer.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+namespace {
+
+const int kMoreMemories = 64;
+
+Limits PageLimits(uint64_t pages) {
+  Limits limits;
+  limits.initial = pages;
+  return limits;
+}
+
+void AddMemories(Environment* env) {
+  for (int i = 0; i < kMoreMemories; ++i)
+    env->EmplaceBackMemory(PageLimits(1));
+}
+
+// A memory mapping a MemoryImage stays a copy-on-write mapping.
+void TestMappedMemory() {
+  std::vector<char> bytes(4 * WABT_PAGE_SIZE, 'a');
+  std::unique_ptr<MemoryImage> image;
+  if (Failed(MemoryImage::Create(bytes.data(), bytes.size(), bytes.size(),
+                                 &image))) {
+    return;
+  }
+
+  Environment env;
+  Index index = env.GetMemoryCount();
+  env.EmplaceBackMemory(PageLimits(4))->data = MemoryBuffer(*image);
+  Memory* memory = env.GetMemory(index);
+  CHECK(memory->data.is_mapped());
+  const char* data = memory->data.data();
+
+  AddMemories(&env);
+  memory = env.GetMemory(index);
+  CHECK(memory->data.is_mapped());
+  CHECK(memory->data.data() == data);
+  CHECK(memory->data[bytes.size() - 1] == 'a');
+}
+
+// A memory in a huge-page region stays in it, without being copied to a
+// new region.
+void TestHugePageMemory() {
+  if (!HugePagesAvailable())
+    return;
+
+  Environment env;
+  env.set_use_huge_pages(true);
+  Index index = env.GetMemoryCount();
+  const uint64_t kPages = 2 * kHugePageSize / WABT_PAGE_SIZE;
+  Memory* memory = env.EmplaceBackMemory(PageLimits(kPages));
+  CHECK(memory->data.uses_huge_pages());
+  CHECK(memory->data.is_mapped());
+  memory->data[0] = 'h';
+  const char* data = memory->data.data();
+  CHECK(reinterpret_cast<uintptr_t>(data) % kHugePageSize == 0);
+
+  AddMemories(&env);
+  memory = env.GetMemory(index);
+  CHECK(memory->data.is_mapped());
+  CHECK(memory->data.data() == data);
+  CHECK(memory->data[0] == 'h');
+}
+
+// A borrowed memory grows in place up to the capacity it was borrowed with,
+// and stays borrowed when the environment grows.
+void TestBorrowedMemory() {
+  std::vector<char> bytes(4 * WABT_PAGE_SIZE);
+  Environment env;
+  Index index = env.GetMemoryCount();
+  env.EmplaceBackMemory(PageLimits(1))->data =
+      MemoryBuffer::Borrow(bytes.data(), WABT_PAGE_SIZE, bytes.size());
+
+  AddMemories(&env);
+  Memory* memory = env.GetMemory(index);
+  CHECK(memory->data.is_borrowed());
+  memory->data.resize(bytes.size());
+  CHECK(memory->data.is_borrowed());
+  CHECK(memory->data.data() == bytes.data());
+  CHECK(memory->data.size() == bytes.size());
+
+  memory->data.resize(bytes.size() + WABT_PAGE_SIZE);
+  CHECK(!memory->data.is_borrowed());
+  CHECK(memory->data.data() != bytes.data());
+}
+
+}  // end anonymous namespace
+
+int main() {
+  TestMappedMemory();
+  TestHugePageMemory();
+  TestBorrowedMemory();
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host memories defined with wasmscript_engine_define_memory must keep
+ * pointing at the host's bytes however many memories are added to the
+ * engine after them. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/wasmscript.h"
+#include "test/test-util.h"
+
+/* (module
+ *   (import "host" "mem" (memory 1 1))
+ *   (func (export "put") (param i32) (i32.store (i32.const 0) (get_local 0)))
+ *   (func (export "get") (result i32) (i32.load (i32.const 0)))) */
+static const uint8_t kImportsMemory[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x09, 0x02, 0x60,
+    0x01, 0x7f, 0x00, 0x60, 0x00, 0x01, 0x7f, 0x02, 0x0e, 0x01, 0x04, 0x68,
+    0x6f, 0x73, 0x74, 0x03, 0x6d, 0x65, 0x6d, 0x02, 0x01, 0x01, 0x01, 0x03,
+    0x03, 0x02, 0x00, 0x01, 0x07, 0x0d, 0x02, 0x03, 0x70, 0x75, 0x74, 0x00,
+    0x00, 0x03, 0x67, 0x65, 0x74, 0x00, 0x01, 0x0a, 0x13, 0x02, 0x09, 0x00,
+    0x41, 0x00, 0x20, 0x00, 0x36, 0x02, 0x00, 0x0b, 0x07, 0x00, 0x41, 0x00,
+    0x28, 0x02, 0x00, 0x0b,
+};
+
+/* (module (memory 1)) */
+static const uint8_t kDefinesMemory[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x05, 0x03, 0x01, 0x00,
+    0x01,
+};
+
+static wasmscript_module_t* Compile(wasmscript_engine_t* engine,
+                                    const uint8_t* data,
+                                    size_t size) {
+  char* error = NULL;
+  wasmscript_module_t* module =
+      wasmscript_module_compile(engine, data, size, &error);
+  if (!module) {
+    fprintf(stderr, "compile failed: %s\n", error);
+    free(error);
+  }
+  CHECK(module);
+  return module;
+}
+
+int main(void) {
+  static uint32_t host_memory[65536 / sizeof(uint32_t)];
+  wasmscript_engine_t* engine = wasmscript_engine_new();
+  CHECK(wasmscript_engine_define_memory(engine, "host", "mem", host_memory,
+                                        sizeof(host_memory)) == WASMSCRIPT_OK);
+  wasmscript_module_t* module =
+      Compile(engine, kImportsMemory, sizeof(kImportsMemory));
+
+  /* Each of these adds a memory to the engine after the imported one. */
+  int i;
+  for (i = 0; i < 8; ++i) {
+    wasmscript_module_delete(
+        Compile(engine, kDefinesMemory, sizeof(kDefinesMemory)));
+  }
+
+  wasmscript_instance_t* instance;
+  CHECK(wasmscript_instance_new(module, &instance) == WASMSCRIPT_OK);
+  wasmscript_func_t* put = wasmscript_instance_get_func(instance, "put");
+  wasmscript_func_t* get = wasmscript_instance_get_func(instance, "get");
+  CHECK(put && get);
+
+  wasmscript_val_t arg, result;
+  arg.i32 = 1234;
+  CHECK(wasmscript_func_call(put, &arg, NULL) == WASMSCRIPT_OK);
+  CHECK(host_memory[0] == 1234);
+
+  host_memory[0] = 5678;
+  CHECK(wasmscript_func_call(get, NULL, &result) == WASMSCRIPT_OK);
+  CHECK(result.i32 == 5678);
+
+  size_t size;
+  CHECK(wasmscript_memory_data(instance, &size) == (uint8_t*)host_memory);
+  CHECK(size == sizeof(host_memory));
+
+  /* Resetting the instance leaves imported memories alone. */
+  CHECK(wasmscript_instance_reset(instance) == WASMSCRIPT_OK);
+  CHECK(wasmscript_memory_data(instance, &size) == (uint8_t*)host_memory);
+  CHECK(host_memory[0] == 5678);
+
+  wasmscript_func_delete(put);
+  wasmscript_func_delete(get);
+  wasmscript_instance_delete(instance);
+  wasmscript_module_delete(module);
+  wasmscript_engine_delete(engine);
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// MemoryPool slots must be reused once released, and a reused slot must
+// read as zero however much of it the previous user wrote.
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "src/memory-buffer.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+
+namespace {
+
+const size_t kSmall = 64 * 1024;
+const size_t kLarge = 256 * 1024;
+
+bool IsZero(const MemoryBuffer& buffer) {
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    if (buffer[i] != 0)
+      return false;
+  }
+  return true;
+}
+
+void TestReuse() {
+  MemoryPool pool({kSmall, kLarge}, 2);
+  const char* data;
+  {
+    MemoryBuffer buffer(kSmall, &pool);
+    CHECK(buffer.is_pooled());
+    CHECK(IsZero(buffer));
+    memset(buffer.data(), 'x', kSmall);
+    data = buffer.data();
+  }
+  MemoryPool::Stats stats = pool.GetStats();
+  CHECK(stats.misses == 1 && stats.hits == 0);
+  CHECK(stats.free_slots == 1 && stats.used_slots == 0);
+  CHECK(stats.resident_bytes == kSmall);
+
+  // A smaller request reuses the slot, cleared up to its size and past it
+  // once it grows.
+  MemoryBuffer buffer(kSmall / 2, &pool);
+  CHECK(buffer.data() == data);
+  CHECK(IsZero(buffer));
+  buffer.resize(kSmall);
+  CHECK(buffer.data() == data);
+  CHECK(IsZero(buffer));
+  stats = pool.GetStats();
+  CHECK(stats.misses == 1 && stats.hits == 1);
+  CHECK(stats.free_slots == 0 && stats.used_slots == 1);
+
+  // Shrinking clears the bytes past the new end.
+  buffer[kSmall - 1] = 'y';
+  buffer.resize(kSmall / 2);
+  buffer.resize(kSmall);
+  CHECK(buffer[kSmall - 1] == 0);
+
+  // Growing past the slot moves to one of the next class, keeping the bytes.
+  buffer[0] = 'z';
+  buffer.resize(kSmall * 2);
+  CHECK(buffer.is_pooled());
+  CHECK(buffer[0] == 'z');
+  CHECK(buffer.size() == kSmall * 2);
+  stats = pool.GetStats();
+  CHECK(stats.misses == 2);
+  CHECK(stats.free_slots == 1 && stats.used_slots == 1);
+
+  // A copy takes the free small slot, with the copied bytes and no others.
+  MemoryBuffer small(kSmall / 4, &pool);
+  small[1] = 'c';
+  {
+    MemoryBuffer copy(small, &pool);
+    CHECK(copy.is_pooled());
+    CHECK(copy[1] == 'c');
+    copy[1] = 0;
+    CHECK(IsZero(copy));
+  }
+}
+
+void TestLimits() {
+  MemoryPool pool({kSmall}, 2);
+  {
+    MemoryBuffer oversized(kLarge, &pool);
+    CHECK(!oversized.is_pooled());
+    CHECK(IsZero(oversized));
+  }
+  CHECK(pool.GetStats().oversized == 1);
+
+  // Only |max_free_slots| released slots are kept.
+  {
+    MemoryBuffer a(kSmall, &pool), b(kSmall, &pool), c(kSmall, &pool);
+    CHECK(pool.GetStats().used_slots == 3);
+  }
+  MemoryPool::Stats stats = pool.GetStats();
+  CHECK(stats.free_slots == 2 && stats.used_slots == 0);
+  CHECK(stats.resident_bytes == 2 * kSmall);
+
+  MemoryPool reserved({kSmall}, 4);
+  reserved.Reserve(kSmall, 8);
+  CHECK(reserved.GetStats().free_slots == 4);
+  MemoryBuffer buffer(kSmall, &reserved);
+  CHECK(reserved.GetStats().hits == 1);
+  CHECK(reserved.GetStats().misses == 0);
+}
+
+// Threads acquiring, dirtying and releasing slots always see zeroed ones.
+void TestThreads() {
+  MemoryPool pool({kSmall}, 4);
+  const int kThreads = 4;
+  const int kRounds = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&pool, t] {
+      for (int i = 0; i < kRounds; ++i) {
+        size_t size = kSmall / (1 + (i + t) % 4);
+        MemoryBuffer buffer(size, &pool);
+        CHECK(IsZero(buffer));
+        memset(buffer.data(), t + 1, size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  MemoryPool::Stats stats = pool.GetStats();
+  CHECK(stats.hits + stats.misses == kThreads * kRounds);
+  CHECK(stats.misses <= kThreads);
+  CHECK(stats.used_slots == 0);
+}
+
+}  // end anonymous namespace
+
+int main() {
+  TestReuse();
+  TestLimits();
+  TestThreads();
+  return 0;
+}
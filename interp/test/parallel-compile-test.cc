@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ReadBinaryInterpParallel must produce the same istream and function
+// offsets as a serial read, whatever the number of threads.
+
+#include <vector>
+
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/cast.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+namespace {
+
+// (module
+//   (type $t (func (param i32) (result i32)))
+//   (table 2 funcref)
+//   (elem (i32.const 0) $fib_plus_one $sum_plus_fib)
+//   (func $sum (type $t) (local i32)
+//     (block (loop (br_if 1 (i32.eqz (local.get 0)))
+//       (local.set 1 (i32.add (local.get 1) (local.get 0)))
+//       (local.set 0 (i32.sub (local.get 0) (i32.const 1)))
+//       (br 0)))
+//     (local.get 1))
+//   (func $fib (type $t)
+//     (if (result i32) (i32.lt_s (local.get 0) (i32.const 2))
+//       (then (local.get 0))
+//       (else (i32.add (call $fib (i32.sub (local.get 0) (i32.const 1)))
+//                      (call $fib (i32.sub (local.get 0) (i32.const 2)))))))
+//   (func $select (type $t)
+//     (block (block (block (br_table 0 1 2 (local.get 0)))
+//       (return (i32.const 10)))
+//       (return (i32.const 20)))
+//     (i32.const 30))
+//   (func $indirect (type $t)
+//     (call_indirect (type $t) (local.get 0)
+//                    (i32.and (local.get 0) (i32.const 1))))
+//   (func $fib_plus_one (type $t)
+//     (i32.add (call $fib (local.get 0)) (i32.const 1)))
+//   (func $sum_plus_fib (type $t)
+//     (i32.add (call $sum (local.get 0)) (call $fib (local.get 0))))
+//   (func (export "main") (type $t)
+//     (i32.add (i32.add (i32.add (i32.add
+//       (call $sum (local.get 0)) (call $fib (local.get 0)))
+//       (call $select (i32.rem_u (local.get 0) (i32.const 4))))
+//       (call $indirect (local.get 0)))
+//       (call $indirect (i32.add (local.get 0) (i32.const 1))))))
+const uint8_t kModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x03, 0x08, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x04, 0x04, 0x01, 0x70, 0x00, 0x02, 0x07, 0x08, 0x01, 0x04,
+    0x6d, 0x61, 0x69, 0x6e, 0x00, 0x06, 0x09, 0x08, 0x01, 0x00, 0x41, 0x00,
+    0x0b, 0x02, 0x04, 0x05, 0x0a, 0x9f, 0x01, 0x07, 0x21, 0x01, 0x01, 0x7f,
+    0x02, 0x40, 0x03, 0x40, 0x20, 0x00, 0x45, 0x0d, 0x01, 0x20, 0x01, 0x20,
+    0x00, 0x6a, 0x21, 0x01, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x21, 0x00, 0x0c,
+    0x00, 0x0b, 0x0b, 0x20, 0x01, 0x0b, 0x1c, 0x00, 0x20, 0x00, 0x41, 0x02,
+    0x48, 0x04, 0x7f, 0x20, 0x00, 0x05, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x10,
+    0x01, 0x20, 0x00, 0x41, 0x02, 0x6b, 0x10, 0x01, 0x6a, 0x0b, 0x0b, 0x1a,
+    0x00, 0x02, 0x40, 0x02, 0x40, 0x02, 0x40, 0x20, 0x00, 0x0e, 0x02, 0x00,
+    0x01, 0x02, 0x0b, 0x41, 0x0a, 0x0f, 0x0b, 0x41, 0x14, 0x0f, 0x0b, 0x41,
+    0x1e, 0x0b, 0x0c, 0x00, 0x20, 0x00, 0x20, 0x00, 0x41, 0x01, 0x71, 0x11,
+    0x00, 0x00, 0x0b, 0x09, 0x00, 0x20, 0x00, 0x10, 0x01, 0x41, 0x01, 0x6a,
+    0x0b, 0x0b, 0x00, 0x20, 0x00, 0x10, 0x00, 0x20, 0x00, 0x10, 0x01, 0x6a,
+    0x0b, 0x20, 0x00, 0x20, 0x00, 0x10, 0x00, 0x20, 0x00, 0x10, 0x01, 0x6a,
+    0x20, 0x00, 0x41, 0x04, 0x70, 0x10, 0x02, 0x6a, 0x20, 0x00, 0x10, 0x03,
+    0x6a, 0x20, 0x00, 0x41, 0x01, 0x6a, 0x10, 0x03, 0x6a, 0x0b,
+};
+
+struct Compiled {
+  std::vector<uint8_t> istream;
+  std::vector<IstreamOffset> func_offsets;
+  uint32_t main_result = 0;
+};
+
+void Compile(int num_threads, Compiled* out) {
+  Environment env;
+  ReadBinaryOptions options;
+  ErrorHandlerBuffer error_handler(Location::Type::Binary);
+  DefinedModule* module = nullptr;
+  CHECK(Succeeded(ReadBinaryInterpParallel(&env, kModule, sizeof(kModule),
+                                           &options, num_threads,
+                                           &error_handler, &module)));
+
+  out->istream = env.istream().data;
+  for (Index i = 0; i < env.GetFuncCount(); ++i)
+    out->func_offsets.push_back(cast<DefinedFunc>(env.GetFunc(i))->offset);
+
+  Executor executor(&env);
+  Value arg;
+  arg.i32 = 10;
+  ExecResult result = executor.RunExport(module->GetExport("main"),
+                                         {TypedValue(Type::I32, arg)});
+  CHECK(result.result == interp::Result::Ok);
+  out->main_result = result.values[0].value.i32;
+}
+
+}  // end anonymous namespace
+
+int main() {
+  Compiled serial;
+  Compile(1, &serial);
+  CHECK(serial.main_result == 351);
+
+  for (int num_threads : {2, 3, 4, 8}) {
+    Compiled parallel;
+    Compile(num_threads, &parallel);
+    CHECK(parallel.istream == serial.istream);
+    CHECK(parallel.func_offsets == serial.func_offsets);
+    CHECK(parallel.main_result == serial.main_result);
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host functions may call back into the guest through the same engine,
+ * nesting calls several levels deep, and a trap in a nested call unwinds to
+ * the host function without disturbing later calls. */
+
+#include <stdint.h>
+
+#include "src/wasmscript.h"
+#include "test/test-util.h"
+
+/* (module
+ *   (import "host" "reenter" (func $reenter (param i32) (result i32)))
+ *   (func (export "fact") (param i32) (result i32)
+ *     (if (result i32) (i32.eqz (get_local 0))
+ *       (then (i32.const 1))
+ *       (else (i32.mul (get_local 0)
+ *                      (call $reenter (i32.sub (get_local 0)
+ *                                              (i32.const 1)))))))
+ *   (func (export "trap") (result i32) (unreachable))) */
+static const uint8_t kModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0a, 0x02, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x60, 0x00, 0x01, 0x7f, 0x02, 0x10, 0x01, 0x04,
+    0x68, 0x6f, 0x73, 0x74, 0x07, 0x72, 0x65, 0x65, 0x6e, 0x74, 0x65, 0x72,
+    0x00, 0x00, 0x03, 0x03, 0x02, 0x00, 0x01, 0x07, 0x0f, 0x02, 0x04, 0x66,
+    0x61, 0x63, 0x74, 0x00, 0x01, 0x04, 0x74, 0x72, 0x61, 0x70, 0x00, 0x02,
+    0x0a, 0x1b, 0x02, 0x15, 0x00, 0x20, 0x00, 0x45, 0x04, 0x7f, 0x41, 0x01,
+    0x05, 0x20, 0x00, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x10, 0x00, 0x6c, 0x0b,
+    0x0b, 0x03, 0x00, 0x00, 0x0b,
+};
+
+typedef struct Context {
+  wasmscript_func_t* fact;
+  wasmscript_func_t* trap;
+  uint32_t trap_at; /* calls "trap" instead of "fact" for this argument */
+  int depth;
+  int max_depth;
+} Context;
+
+/* Computes fact(args[0]) by calling back into the guest. */
+static wasmscript_result_t Reenter(void* user_data,
+                                   const wasmscript_val_t* args,
+                                   wasmscript_val_t* results) {
+  Context* context = (Context*)user_data;
+  wasmscript_result_t result;
+  if (++context->depth > context->max_depth)
+    context->max_depth = context->depth;
+  if (args[0].i32 == context->trap_at) {
+    result = wasmscript_func_call(context->trap, NULL, results);
+    CHECK(result != WASMSCRIPT_OK);
+  } else {
+    result = wasmscript_func_call(context->fact, args, results);
+  }
+  --context->depth;
+  return result;
+}
+
+static uint32_t Fact(Context* context, uint32_t n) {
+  wasmscript_val_t arg, result;
+  arg.i32 = n;
+  CHECK(wasmscript_func_call(context->fact, &arg, &result) == WASMSCRIPT_OK);
+  return result.i32;
+}
+
+int main(void) {
+  static const wasmscript_valkind_t kI32[] = {WASMSCRIPT_I32};
+  Context context = {NULL, NULL, UINT32_MAX, 0, 0};
+
+  wasmscript_engine_t* engine = wasmscript_engine_new();
+  CHECK(engine);
+  CHECK(wasmscript_engine_define_func(engine, "host", "reenter", kI32, 1,
+                                      kI32, 1, Reenter,
+                                      &context) == WASMSCRIPT_OK);
+  wasmscript_module_t* module =
+      wasmscript_module_compile(engine, kModule, sizeof(kModule), NULL);
+  CHECK(module);
+  wasmscript_instance_t* instance;
+  CHECK(wasmscript_instance_new(module, &instance) == WASMSCRIPT_OK);
+  wasmscript_module_delete(module);
+  context.fact = wasmscript_instance_get_func(instance, "fact");
+  context.trap = wasmscript_instance_get_func(instance, "trap");
+  CHECK(context.fact && context.trap);
+
+  /* fact(5) nests five host calls, each running fact again. */
+  CHECK(Fact(&context, 5) == 120);
+  CHECK(context.max_depth == 5);
+  CHECK(context.depth == 0);
+
+  /* A trap three levels down fails the outermost call... */
+  wasmscript_val_t arg, result;
+  context.trap_at = 2;
+  arg.i32 = 5;
+  CHECK(wasmscript_func_call(context.fact, &arg, &result) != WASMSCRIPT_OK);
+  CHECK(context.depth == 0);
+
+  /* ...and leaves the engine usable. */
+  context.trap_at = UINT32_MAX;
+  CHECK(Fact(&context, 6) == 720);
+  CHECK(Fact(&context, 0) == 1);
+
+  wasmscript_func_delete(context.fact);
+  wasmscript_func_delete(context.trap);
+  wasmscript_instance_delete(instance);
+  wasmscript_engine_delete(engine);
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Executor::ResetInstance must restore an instance's globals, memory
+// (including its size) and table to the state Instantiate or Preinitialize
+// left them in.
+
+#include <memory>
+
+#include "src/binary-reader-interp.h"
+#include "src/binary-reader.h"
+#include "src/error-handler.h"
+#include "src/interp.h"
+#include "test/test-util.h"
+
+using namespace wabt;
+using namespace wabt::interp;
+
+namespace {
+
+// (module
+//   (table 1 funcref)
+//   (memory 1 2)
+//   (global $g (mut i32) (i32.const 0))
+//   (start $start)
+//   (elem (i32.const 0) $one)
+//   (func $start (global.set $g (i32.const 100)))
+//   (func (export "init")
+//     (global.set $g (i32.const 500))
+//     (i32.store8 (i32.const 1) (i32.const 9)))
+//   (func (export "mutate")
+//     (global.set $g (i32.add (global.get $g) (i32.const 1)))
+//     (i32.store8 (i32.const 0) (i32.add (i32.load8_u (i32.const 0))
+//                                        (i32.const 1)))
+//     (drop (memory.grow (i32.const 1))))
+//   (func $one (result i32) (i32.const 1))
+//   (data (i32.const 0) "\05"))
+const uint8_t kModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02, 0x60,
+    0x00, 0x00, 0x60, 0x00, 0x01, 0x7f, 0x03, 0x05, 0x04, 0x00, 0x00, 0x00,
+    0x01, 0x04, 0x04, 0x01, 0x70, 0x00, 0x01, 0x05, 0x04, 0x01, 0x01, 0x01,
+    0x02, 0x06, 0x06, 0x01, 0x7f, 0x01, 0x41, 0x00, 0x0b, 0x07, 0x11, 0x02,
+    0x04, 0x69, 0x6e, 0x69, 0x74, 0x00, 0x01, 0x06, 0x6d, 0x75, 0x74, 0x61,
+    0x74, 0x65, 0x00, 0x02, 0x08, 0x01, 0x00, 0x09, 0x07, 0x01, 0x00, 0x41,
+    0x00, 0x0b, 0x01, 0x03, 0x0a, 0x39, 0x04, 0x07, 0x00, 0x41, 0xe4, 0x00,
+    0x24, 0x00, 0x0b, 0x0e, 0x00, 0x41, 0xf4, 0x03, 0x24, 0x00, 0x41, 0x01,
+    0x41, 0x09, 0x3a, 0x00, 0x00, 0x0b, 0x1b, 0x00, 0x23, 0x00, 0x41, 0x01,
+    0x6a, 0x24, 0x00, 0x41, 0x00, 0x41, 0x00, 0x2d, 0x00, 0x00, 0x41, 0x01,
+    0x6a, 0x3a, 0x00, 0x00, 0x41, 0x01, 0x40, 0x00, 0x1a, 0x0b, 0x04, 0x00,
+    0x41, 0x01, 0x0b, 0x0b, 0x07, 0x01, 0x00, 0x41, 0x00, 0x0b, 0x01, 0x05,
+};
+
+struct State {
+  uint32_t global;
+  uint8_t byte0;
+  uint8_t byte1;
+  uint64_t pages;
+  Index table_entry;
+};
+
+bool operator==(const State& a, const State& b) {
+  return a.global == b.global && a.byte0 == b.byte0 && a.byte1 == b.byte1 &&
+         a.pages == b.pages && a.table_entry == b.table_entry;
+}
+
+class ResetTest {
+ public:
+  explicit ResetTest(bool use_memory_template) : executor_(&env_) {
+    ReadBinaryOptions options;
+    ErrorHandlerBuffer error_handler(Location::Type::Binary);
+    global_index_ = env_.GetGlobalCount();
+    CHECK(Succeeded(ReadBinaryInterp(&env_, kModule, sizeof(kModule),
+                                     &options, &error_handler, &module_)));
+    compiled_.reset(new CompiledModule(&env_, module_, use_memory_template));
+  }
+
+  Executor* executor() { return &executor_; }
+  CompiledModule* compiled() { return compiled_.get(); }
+
+  State GetState(Instance* instance) {
+    Memory* memory = instance->GetMemory(module_->memory_index);
+    State state;
+    state.global = instance->GetGlobal(global_index_)->typed_value.value.i32;
+    state.byte0 = memory->data[0];
+    state.byte1 = memory->data[1];
+    state.pages = memory->data.size() / WABT_PAGE_SIZE;
+    state.table_entry =
+        instance->GetTable(module_->table_index)->func_indexes[0];
+    return state;
+  }
+
+  // Runs "mutate" twice and overwrites the table entry.
+  void Mutate(Instance* instance) {
+    ExportHandle mutate;
+    CHECK(executor_.ResolveExport(instance, "mutate", &mutate) ==
+          interp::Result::Ok);
+    CHECK(executor_.Call(mutate, nullptr, nullptr) == interp::Result::Ok);
+    CHECK(executor_.Call(mutate, nullptr, nullptr) == interp::Result::Ok);
+    instance->GetTable(module_->table_index)->func_indexes[0] = kInvalidIndex;
+  }
+
+ private:
+  Environment env_;
+  Executor executor_;
+  Index global_index_;
+  DefinedModule* module_ = nullptr;
+  std::unique_ptr<CompiledModule> compiled_;
+};
+
+void TestReset(bool use_memory_template) {
+  ResetTest test(use_memory_template);
+  std::unique_ptr<Instance> instance;
+  CHECK(test.executor()->Instantiate(test.compiled(), &instance) ==
+        interp::Result::Ok);
+  State initial = test.GetState(instance.get());
+  CHECK(initial.global == 100);
+  CHECK(initial.byte0 == 5 && initial.byte1 == 0);
+  CHECK(initial.pages == 1);
+  CHECK(initial.table_entry != kInvalidIndex);
+
+  for (int i = 0; i < 2; ++i) {
+    test.Mutate(instance.get());
+    State mutated = test.GetState(instance.get());
+    CHECK(mutated.global == 102);
+    CHECK(mutated.byte0 == 7);
+    CHECK(mutated.pages == 2);
+    CHECK(mutated.table_entry == kInvalidIndex);
+
+    CHECK(test.executor()->ResetInstance(instance.get()) ==
+          interp::Result::Ok);
+    CHECK(test.GetState(instance.get()) == initial);
+  }
+}
+
+// An instance of a preinitialized module resets to the state "init" left,
+// without running the start function again.
+void TestResetPreinitialized(bool use_memory_template) {
+  ResetTest test(use_memory_template);
+  std::unique_ptr<Instance> instance;
+  CHECK(test.executor()->Preinitialize(test.compiled(), "init", &instance) ==
+        interp::Result::Ok);
+  State initial = test.GetState(instance.get());
+  CHECK(initial.global == 500);
+  CHECK(initial.byte0 == 5 && initial.byte1 == 9);
+
+  test.Mutate(instance.get());
+  CHECK(test.executor()->ResetInstance(instance.get()) == interp::Result::Ok);
+  CHECK(test.GetState(instance.get()) == initial);
+
+  std::unique_ptr<Instance> other;
+  CHECK(test.executor()->Instantiate(test.compiled(), &other) ==
+        interp::Result::Ok);
+  CHECK(test.GetState(other.get()) == initial);
+}
+
+}  // end anonymous namespace
+
+int main() {
+  for (bool use_memory_template : {true, false}) {
+    TestReset(use_memory_template);
+    TestResetPreinitialized(use_memory_template);
+  }
+  return 0;
+}
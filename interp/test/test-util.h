@@ -0,0 +1,35 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_TEST_UTIL_H_
+#define WABT_TEST_UTIL_H_
+
+/* Shared by the programs in test/, which may be C or C++. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Exits with a message naming |expr| if it is false. */
+#define CHECK(expr)                                                  \
+  do {                                                               \
+    if (!(expr)) {                                                   \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+              #expr);                                                \
+      exit(1);                                                       \
+    }                                                                \
+  } while (0)
+
+#endif /* WABT_TEST_UTIL_H_ */
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* A smoke test of the C API: host functions and memory, compiling,
+ * instantiating and calling. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/wasmscript.h"
+#include "test/test-util.h"
+
+/* (module
+ *   (import "host" "add" (func $add (param i32 i32) (result i32)))
+ *   (import "host" "mem" (memory 1 1))
+ *   (func (export "run") (param i32) (result i32)
+ *     (i32.store (i32.const 4) (call $add (get_local 0) (i32.const 10)))
+ *     (i32.load (i32.const 4)))) */
+static const uint8_t kModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0c, 0x02, 0x60,
+    0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x60, 0x01, 0x7f, 0x01, 0x7f, 0x02, 0x19,
+    0x02, 0x04, 0x68, 0x6f, 0x73, 0x74, 0x03, 0x61, 0x64, 0x64, 0x00, 0x00,
+    0x04, 0x68, 0x6f, 0x73, 0x74, 0x03, 0x6d, 0x65, 0x6d, 0x02, 0x01, 0x01,
+    0x01, 0x03, 0x02, 0x01, 0x01, 0x07, 0x07, 0x01, 0x03, 0x72, 0x75, 0x6e,
+    0x00, 0x01, 0x0a, 0x14, 0x01, 0x12, 0x00, 0x41, 0x04, 0x20, 0x00, 0x41,
+    0x0a, 0x10, 0x00, 0x36, 0x02, 0x00, 0x41, 0x04, 0x28, 0x02, 0x00, 0x0b,
+};
+
+static wasmscript_result_t Add(void* user_data,
+                               const wasmscript_val_t* args,
+                               wasmscript_val_t* results) {
+  ++*(int*)user_data;
+  results[0].i32 = args[0].i32 + args[1].i32;
+  return WASMSCRIPT_OK;
+}
+
+int main(void) {
+  static uint32_t host_memory[65536 / sizeof(uint32_t)];
+  static const wasmscript_valkind_t kParams[] = {WASMSCRIPT_I32,
+                                                 WASMSCRIPT_I32};
+  static const wasmscript_valkind_t kResults[] = {WASMSCRIPT_I32};
+  int num_calls = 0;
+
+  wasmscript_engine_t* engine = wasmscript_engine_new();
+  CHECK(engine);
+  CHECK(wasmscript_engine_define_func(engine, "host", "add", kParams, 2,
+                                      kResults, 1, Add,
+                                      &num_calls) == WASMSCRIPT_OK);
+  CHECK(wasmscript_engine_define_memory(engine, "host", "mem", host_memory,
+                                        sizeof(host_memory)) == WASMSCRIPT_OK);
+
+  /* A truncated module reports an error. */
+  char* error = NULL;
+  CHECK(!wasmscript_module_compile(engine, kModule, 12, &error));
+  CHECK(error && error[0]);
+  free(error);
+
+  error = NULL;
+  wasmscript_module_t* module =
+      wasmscript_module_compile(engine, kModule, sizeof(kModule), &error);
+  CHECK(module);
+  CHECK(!error);
+
+  wasmscript_instance_t* instance;
+  CHECK(wasmscript_instance_new(module, &instance) == WASMSCRIPT_OK);
+  wasmscript_module_delete(module);
+  CHECK(!wasmscript_instance_get_func(instance, "missing"));
+  wasmscript_func_t* run = wasmscript_instance_get_func(instance, "run");
+  CHECK(run);
+
+  size_t num_params, num_results;
+  wasmscript_func_type(run, &num_params, &num_results);
+  CHECK(num_params == 1 && num_results == 1);
+  CHECK(wasmscript_func_param(run, 0) == WASMSCRIPT_I32);
+  CHECK(wasmscript_func_result(run, 0) == WASMSCRIPT_I32);
+
+  wasmscript_val_t arg, result;
+  arg.i32 = 32;
+  CHECK(wasmscript_func_call(run, &arg, &result) == WASMSCRIPT_OK);
+  CHECK(result.i32 == 42);
+  CHECK(num_calls == 1);
+  CHECK(host_memory[1] == 42);
+
+  size_t size;
+  uint8_t* data = wasmscript_memory_data(instance, &size);
+  CHECK(data == (uint8_t*)host_memory);
+  CHECK(size == sizeof(host_memory));
+
+  wasmscript_func_delete(run);
+  wasmscript_instance_delete(instance);
+  wasmscript_engine_delete(engine);
+  return 0;
+}